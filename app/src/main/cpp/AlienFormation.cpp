@@ -0,0 +1,155 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "AlienFormation.h"
+#include <cmath>
+#include <stdexcept>
+
+AlienFormation::AlienFormation(uint32_t columns, uint32_t rows, glm::vec2 origin,
+                               glm::vec2 spacing, std::array<float, 2> alienSize)
+        : columns_(columns), rows_(rows), startOrigin_(origin), origin_(origin),
+          spacing_(spacing), alienSize_(alienSize), aliens_(columns * rows),
+          columnRows_(columns), liveColumns_((columns + 63) / 64), rowCounts_(rows) {
+    if (rows > MAX_ROWS || columns == 0 || rows == 0) {
+        LOGE("Alien formation of %ux%u isn't supported", columns, rows);
+        throw std::runtime_error("Bad alien formation size");
+    }
+    reset();
+}
+
+void AlienFormation::reset() {
+    origin_ = startOrigin_;
+    direction_ = 1.0f;
+    lastMove_ = glm::vec2(0.0f);
+    for (auto &alien: aliens_) {
+        alien.active = true;
+        alien.hp = 3;
+        alien.widthHeight = alienSize_;
+    }
+    uint64_t allRows = rows_ == 64 ? ~0ull : (1ull << rows_) - 1;
+    std::fill(columnRows_.begin(), columnRows_.end(), allRows);
+    std::fill(liveColumns_.begin(), liveColumns_.end(), ~0ull);
+    if (columns_ % 64) liveColumns_.back() = (1ull << (columns_ % 64)) - 1;
+    std::fill(rowCounts_.begin(), rowCounts_.end(), columns_);
+    liveRows_ = allRows;
+    aliveCount_ = columns_ * rows_;
+}
+
+int AlienFormation::leftmostColumn() const {
+    for (uint32_t word = 0; word < liveColumns_.size(); ++word) {
+        if (liveColumns_[word]) return int(word * 64 + __builtin_ctzll(liveColumns_[word]));
+    }
+    return -1;
+}
+
+int AlienFormation::rightmostColumn() const {
+    for (uint32_t word = liveColumns_.size(); word-- > 0;) {
+        if (liveColumns_[word]) return int(word * 64 + 63 - __builtin_clzll(liveColumns_[word]));
+    }
+    return -1;
+}
+
+void AlienFormation::update(float speed, float deltaTime, float edge, float drop) {
+    glm::vec2 previousOrigin = origin_;
+    int left = leftmostColumn();
+    if (left < 0) return;
+    int right = rightmostColumn();
+    float leftX = origin_.x + float(left) * spacing_.x;
+    float rightX = origin_.x + float(right) * spacing_.x;
+
+    // keep the live edge just inside, then move
+    if (rightX > edge) origin_.x -= rightX - edge;
+    else if (leftX < -edge) origin_.x += -edge - leftX;
+    origin_.x += speed * direction_ * deltaTime;
+
+    leftX = origin_.x + float(left) * spacing_.x;
+    rightX = origin_.x + float(right) * spacing_.x;
+    if (rightX > edge || leftX < -edge) {
+        direction_ = -direction_;
+        origin_.y -= drop;
+    }
+    lastMove_ = origin_ - previousOrigin;
+}
+
+AABB AlienFormation::bounds(uint32_t index) const {
+    glm::vec2 pos = position(index);
+    return Collision::getAABB(pos.x, pos.y, alienSize_[0], alienSize_[1]);
+}
+
+void AlienFormation::kill(uint32_t index) {
+    if (!alive(index)) return;
+    uint32_t column = index % columns_, row = index / columns_;
+    aliens_[index].active = false;
+    columnRows_[column] &= ~(1ull << row);
+    if (!columnRows_[column]) liveColumns_[column / 64] &= ~(1ull << (column % 64));
+    if (--rowCounts_[row] == 0) liveRows_ &= ~(1ull << row);
+    aliveCount_--;
+}
+
+int AlienFormation::sweepTest(const AABB &start, glm::vec2 displacement,
+                              float &timeOfImpact) const {
+    // in the formation's frame: the aliens sit still at their current spots, the box starts
+    // shifted by the formation's move and only travels the difference
+    AABB moving = {start.minX + lastMove_.x, start.minY + lastMove_.y,
+                   start.maxX + lastMove_.x, start.maxY + lastMove_.y};
+    glm::vec2 relative = displacement - lastMove_;
+    AABB box = Collision::sweptBounds(moving, relative.x, relative.y);
+
+    // columns/rows whose alien could reach the box, clamped before the int conversion
+    float halfW = alienSize_[0] * 0.5f, halfH = alienSize_[1] * 0.5f;
+    auto clampCell = [](float cell, uint32_t count) {
+        return int(std::fmin(std::fmax(cell, -1.0f), float(count)));
+    };
+    int firstColumn = clampCell(std::floor((box.minX - halfW - origin_.x) / spacing_.x),
+                                columns_);
+    int lastColumn = clampCell(std::ceil((box.maxX + halfW - origin_.x) / spacing_.x),
+                               columns_);
+    int firstRow = clampCell(std::floor((origin_.y - box.maxY - halfH) / spacing_.y), rows_);
+    int lastRow = clampCell(std::ceil((origin_.y - box.minY + halfH) / spacing_.y), rows_);
+
+    int first = -1;
+    for (int row = std::max(firstRow, 0); row <= std::min(lastRow, int(rows_) - 1); ++row) {
+        if (!((liveRows_ >> row) & 1)) continue;
+        for (int column = std::max(firstColumn, 0);
+             column <= std::min(lastColumn, int(columns_) - 1); ++column) {
+            uint32_t index = uint32_t(row) * columns_ + uint32_t(column);
+            float t;
+            if (!alive(index) ||
+                !Collision::sweep(moving, relative.x, relative.y, bounds(index), t))
+                continue;
+            if (first < 0 || t < timeOfImpact) {
+                first = int(index);
+                timeOfImpact = t;
+            }
+        }
+    }
+    return first;
+}
+
+int AlienFormation::pickShooter(uint32_t n) const {
+    uint32_t liveColumnCount = 0;
+    for (uint64_t word: liveColumns_) liveColumnCount += __builtin_popcountll(word);
+    if (liveColumnCount == 0) return -1;
+
+    n %= liveColumnCount;
+    for (uint32_t word = 0; word < liveColumns_.size(); ++word) {
+        uint32_t inWord = __builtin_popcountll(liveColumns_[word]);
+        if (n >= inWord) {
+            n -= inWord;
+            continue;
+        }
+        uint64_t bits = liveColumns_[word];
+        for (; n > 0; --n) bits &= bits - 1; // drop the lowest set bits until the n-th
+        uint32_t column = word * 64 + __builtin_ctzll(bits);
+        uint32_t bottomRow = 63 - __builtin_clzll(columnRows_[column]);
+        return int(bottomRow * columns_ + column);
+    }
+    return -1;
+}
+
+float AlienFormation::lowestY() const {
+    if (!liveRows_) return origin_.y;
+    uint32_t bottomRow = 63 - __builtin_clzll(liveRows_);
+    return origin_.y - float(bottomRow) * spacing_.y;
+}
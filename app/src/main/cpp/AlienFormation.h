@@ -0,0 +1,83 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_ALIENFORMATION_H
+#define SPACEINVADERS3D_ALIENFORMATION_H
+
+#include "GameObjectData.h"
+#include "Collision.h"
+
+// The alien wave as one grid: a single origin moves the whole formation, and alive bitmasks per
+// column (over rows) and over columns/rows answer "leftmost/rightmost/lowest live" and "who's
+// at this spot" without touching every alien. Index = row * columns + column, row 0 is the top.
+// Positions are in alien space (y up), bullets have to flip y before asking.
+class AlienFormation {
+public:
+    // one bit per row in a column mask
+    static constexpr uint32_t MAX_ROWS = 64;
+
+    AlienFormation(uint32_t columns, uint32_t rows, glm::vec2 origin, glm::vec2 spacing,
+                   std::array<float, 2> alienSize);
+
+    // everyone alive back at the start position, moving right
+    void reset();
+
+    // slides the formation, when the live edge passes +-edge it turns around and drops
+    void update(float speed, float deltaTime, float edge = 0.85f, float drop = 0.04f);
+
+    bool alive(uint32_t index) const {
+        return (columnRows_[index % columns_] >> (index / columns_)) & 1;
+    }
+
+    Alien &alien(uint32_t index) { return aliens_[index]; }
+
+    glm::vec2 position(uint32_t index) const {
+        return {origin_.x + float(index % columns_) * spacing_.x,
+                origin_.y - float(index / columns_) * spacing_.y};
+    }
+
+    // between the last two update()s, for drawing at display rate (Time::alpha)
+    glm::vec2 position(uint32_t index, float alpha) const {
+        return position(index) - lastMove_ * (1.0f - alpha);
+    }
+
+    AABB bounds(uint32_t index) const;
+
+    void kill(uint32_t index);
+
+    // live alien a box moving by displacement over the last step hits first, -1 if none.
+    // box is where it started, in alien space. The formation's own move in the last update() is
+    // taken out, and only the grid cells under the swept box are looked at
+    int sweepTest(const AABB &box, glm::vec2 displacement, float &timeOfImpact) const;
+
+    // bottom-most live alien of the n-th live column (n wraps), -1 if nobody is left
+    int pickShooter(uint32_t n) const;
+
+    // centre y of the lowest row that still has someone alive
+    float lowestY() const;
+
+    uint32_t aliveCount() const { return aliveCount_; }
+
+    uint32_t size() const { return columns_ * rows_; }
+
+private:
+    uint32_t columns_, rows_;
+    glm::vec2 startOrigin_, origin_, spacing_;
+    std::array<float, 2> alienSize_;
+    float direction_ = 1.0f; // 1 = right, -1 = left
+    glm::vec2 lastMove_{0.0f};
+    uint32_t aliveCount_ = 0;
+    std::vector<Alien> aliens_;
+    std::vector<uint64_t> columnRows_;   // per column, bit r = row r alive
+    std::vector<uint64_t> liveColumns_;  // bit c = column c has anyone alive
+    std::vector<uint32_t> rowCounts_;
+    uint64_t liveRows_ = 0;
+
+    int leftmostColumn() const;
+
+    int rightmostColumn() const;
+};
+
+
+#endif //SPACEINVADERS3D_ALIENFORMATION_H
@@ -0,0 +1,52 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "AssetLoader.h"
+#include <fstream>
+
+#ifdef __ANDROID__
+AssetLoader::AssetLoader(AAssetManager *assetManager) : assetManager(assetManager) {}
+#endif
+
+AssetLoader::AssetLoader(std::string rootDir) : rootDir(std::move(rootDir)) {
+    if (!this->rootDir.empty() && this->rootDir.back() != '/') this->rootDir += '/';
+}
+
+std::vector<uint8_t> AssetLoader::load(const std::string &path) const {
+    std::vector<uint8_t> data;
+#ifdef __ANDROID__
+    if (assetManager) {
+        AAsset *asset = AAssetManager_open(assetManager, path.c_str(), AASSET_MODE_STREAMING);
+        if (!asset) {
+            LOGE("Asset not found: %s", path.c_str());
+            return data;
+        }
+        data.resize(AAsset_getLength(asset));
+        AAsset_read(asset, data.data(), data.size());
+        AAsset_close(asset);
+        return data;
+    }
+#endif
+    std::ifstream file(rootDir + path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        LOGE("Asset not found: %s%s", rootDir.c_str(), path.c_str());
+        return data;
+    }
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(data.data()), data.size());
+    return data;
+}
+
+bool AssetLoader::exists(const std::string &path) const {
+#ifdef __ANDROID__
+    if (assetManager) {
+        AAsset *asset = AAssetManager_open(assetManager, path.c_str(), AASSET_MODE_UNKNOWN);
+        if (!asset) return false;
+        AAsset_close(asset);
+        return true;
+    }
+#endif
+    return std::ifstream(rootDir + path, std::ios::binary).good();
+}
@@ -0,0 +1,34 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_ASSETLOADER_H
+#define SPACEINVADERS3D_ASSETLOADER_H
+
+#include "GameObjectData.h"
+#include <string>
+
+// Reads game assets either through the APK's AAssetManager or from a plain directory
+// (headless/desktop runs). Paths are relative to the assets root, e.g. "shaders/main.vert.spv".
+class AssetLoader {
+public:
+#ifdef __ANDROID__
+    explicit AssetLoader(AAssetManager *assetManager);
+#endif
+
+    explicit AssetLoader(std::string rootDir);
+
+    // returns an empty vector if the asset doesn't exist
+    std::vector<uint8_t> load(const std::string &path) const;
+
+    bool exists(const std::string &path) const;
+
+private:
+#ifdef __ANDROID__
+    AAssetManager *assetManager = nullptr;
+#endif
+    std::string rootDir;
+};
+
+
+#endif //SPACEINVADERS3D_ASSETLOADER_H
@@ -3,6 +3,16 @@
 //
 
 #include "Collision.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 bool Collision::isColliding(const AABB &a, const AABB &b) {
     return (a.minX < b.maxX && a.maxX > b.minX &&
@@ -14,3 +24,216 @@ AABB Collision::getAABB(float cx, float cy, float width, float height) {
     float halfH = height * 0.5f;
     return { cx - halfW, cy - halfH, cx + halfW, cy + halfH };
 }
+
+bool Collision::sweep(const AABB &moving, float dx, float dy, const AABB &target,
+                      float &timeOfImpact) {
+    // slab test on the Minkowski difference, per axis the open interval of t where they overlap
+    float enter = 0.0f, exit = 1.0f;
+    auto axis = [&enter, &exit](float aMin, float aMax, float bMin, float bMax, float d) {
+        if (d == 0.0f) return aMin < bMax && aMax > bMin;
+        float t0 = (bMin - aMax) / d;
+        float t1 = (bMax - aMin) / d;
+        if (t0 > t1) std::swap(t0, t1);
+        enter = std::max(enter, t0);
+        exit = std::min(exit, t1);
+        return enter < exit;
+    };
+    if (!axis(moving.minX, moving.maxX, target.minX, target.maxX, dx)) return false;
+    if (!axis(moving.minY, moving.maxY, target.minY, target.maxY, dy)) return false;
+    timeOfImpact = enter;
+    return true;
+}
+
+AABB Collision::sweptBounds(const AABB &box, float dx, float dy) {
+    return {box.minX + std::min(dx, 0.0f), box.minY + std::min(dy, 0.0f),
+            box.maxX + std::max(dx, 0.0f), box.maxY + std::max(dy, 0.0f)};
+}
+
+void AABBArray::clear() {
+    minX.clear();
+    minY.clear();
+    maxX.clear();
+    maxY.clear();
+}
+
+void AABBArray::resize(size_t size) {
+    minX.resize(size);
+    minY.resize(size);
+    maxX.resize(size);
+    maxY.resize(size);
+}
+
+void AABBArray::set(size_t index, const AABB &box) {
+    minX[index] = box.minX;
+    minY[index] = box.minY;
+    maxX[index] = box.maxX;
+    maxY[index] = box.maxY;
+}
+
+void AABBArray::push(const AABB &box) {
+    resize(size() + 1);
+    set(size() - 1, box);
+}
+
+// same compares as isColliding(), ordered so a NaN anywhere means no hit on every path
+static inline bool overlaps(const AABB &a, const AABBBatch &boxes, uint32_t i) {
+    return a.minX < boxes.maxX[i] && a.maxX > boxes.minX[i] &&
+           a.minY < boxes.maxY[i] && a.maxY > boxes.minY[i];
+}
+
+void Collision::isCollidingBatchScalar(const AABB &box, const AABBBatch &boxes,
+                                       uint64_t *hitMask) {
+    std::fill(hitMask, hitMask + (boxes.count + 63) / 64, 0);
+    for (uint32_t i = 0; i < boxes.count; ++i) {
+        if (overlaps(box, boxes, i)) hitMask[i / 64] |= 1ull << (i % 64);
+    }
+}
+
+void Collision::isCollidingBatch(const AABB &box, const AABBBatch &boxes, uint64_t *hitMask) {
+    std::fill(hitMask, hitMask + (boxes.count + 63) / 64, 0);
+    uint32_t i = 0;
+
+    // groups of 4 (8 with AVX) never straddle a mask word
+#if defined(__ARM_NEON)
+    float32x4_t minX = vdupq_n_f32(box.minX), minY = vdupq_n_f32(box.minY);
+    float32x4_t maxX = vdupq_n_f32(box.maxX), maxY = vdupq_n_f32(box.maxY);
+    const uint32_t laneBitsInit[4] = {1, 2, 4, 8};
+    uint32x4_t laneBits = vld1q_u32(laneBitsInit);
+    for (; i + 4 <= boxes.count; i += 4) {
+        uint32x4_t hit = vandq_u32(vcltq_f32(minX, vld1q_f32(boxes.maxX + i)),
+                                   vcgtq_f32(maxX, vld1q_f32(boxes.minX + i)));
+        hit = vandq_u32(hit, vcltq_f32(minY, vld1q_f32(boxes.maxY + i)));
+        hit = vandq_u32(hit, vcgtq_f32(maxY, vld1q_f32(boxes.minY + i)));
+        // horizontal add works on armv7 too, vaddvq is aarch64 only
+        uint32x4_t bits = vandq_u32(hit, laneBits);
+        uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+        sum = vpadd_u32(sum, sum);
+        hitMask[i / 64] |= (uint64_t) vget_lane_u32(sum, 0) << (i % 64);
+    }
+#elif defined(__AVX__)
+    __m256 minX = _mm256_set1_ps(box.minX), minY = _mm256_set1_ps(box.minY);
+    __m256 maxX = _mm256_set1_ps(box.maxX), maxY = _mm256_set1_ps(box.maxY);
+    for (; i + 8 <= boxes.count; i += 8) {
+        __m256 hit = _mm256_and_ps(
+                _mm256_cmp_ps(minX, _mm256_loadu_ps(boxes.maxX + i), _CMP_LT_OQ),
+                _mm256_cmp_ps(maxX, _mm256_loadu_ps(boxes.minX + i), _CMP_GT_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(minY, _mm256_loadu_ps(boxes.maxY + i),
+                                               _CMP_LT_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(maxY, _mm256_loadu_ps(boxes.minY + i),
+                                               _CMP_GT_OQ));
+        hitMask[i / 64] |= (uint64_t) _mm256_movemask_ps(hit) << (i % 64);
+    }
+#elif defined(__SSE2__)
+    __m128 minX = _mm_set1_ps(box.minX), minY = _mm_set1_ps(box.minY);
+    __m128 maxX = _mm_set1_ps(box.maxX), maxY = _mm_set1_ps(box.maxY);
+    for (; i + 4 <= boxes.count; i += 4) {
+        __m128 hit = _mm_and_ps(_mm_cmplt_ps(minX, _mm_loadu_ps(boxes.maxX + i)),
+                                _mm_cmpgt_ps(maxX, _mm_loadu_ps(boxes.minX + i)));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(minY, _mm_loadu_ps(boxes.maxY + i)));
+        hit = _mm_and_ps(hit, _mm_cmpgt_ps(maxY, _mm_loadu_ps(boxes.minY + i)));
+        hitMask[i / 64] |= (uint64_t) _mm_movemask_ps(hit) << (i % 64);
+    }
+#endif
+    for (; i < boxes.count; ++i) {
+        if (overlaps(box, boxes, i)) hitMask[i / 64] |= 1ull << (i % 64);
+    }
+}
+
+uint32_t Collision::collidingIndices(const AABB &box, const AABBBatch &boxes, uint32_t *hits) {
+    uint32_t hitCount = 0;
+    uint64_t mask[4];
+    // a few mask words at a time so this doesn't need scratch memory
+    for (uint32_t first = 0; first < boxes.count; first += 256) {
+        AABBBatch chunk{boxes.minX + first, boxes.minY + first, boxes.maxX + first,
+                        boxes.maxY + first, std::min(256u, boxes.count - first)};
+        isCollidingBatch(box, chunk, mask);
+        for (uint32_t word = 0; word < (chunk.count + 63) / 64; ++word) {
+            for (uint64_t bits = mask[word]; bits; bits &= bits - 1) {
+                hits[hitCount++] = first + word * 64 + __builtin_ctzll(bits);
+            }
+        }
+    }
+    return hitCount;
+}
+
+Broadphase::Broadphase(float cellSize, AABB bounds)
+        : bounds_(bounds), invCellSize_(1.0f / cellSize) {
+    columns_ = std::max(1u, (uint32_t) std::ceil((bounds.maxX - bounds.minX) * invCellSize_));
+    rows_ = std::max(1u, (uint32_t) std::ceil((bounds.maxY - bounds.minY) * invCellSize_));
+    cellStart_.resize(columns_ * rows_ + 1);
+}
+
+void Broadphase::clear() {
+    proxies_.clear();
+    pairs_.clear();
+}
+
+void Broadphase::add(const AABB &box, CollisionLayer layer, uint32_t mask, uint32_t userId) {
+    proxies_.push_back({box, layer, mask, userId});
+}
+
+uint32_t Broadphase::column(float x) const {
+    float c = (x - bounds_.minX) * invCellSize_;
+    return c <= 0.0f ? 0 : std::min(columns_ - 1, (uint32_t) c);
+}
+
+uint32_t Broadphase::row(float y) const {
+    float r = (y - bounds_.minY) * invCellSize_;
+    return r <= 0.0f ? 0 : std::min(rows_ - 1, (uint32_t) r);
+}
+
+const std::vector<CollisionPair> &Broadphase::findPairs() {
+    pairs_.clear();
+
+    // counting sort of the proxies into cells, no per-cell allocations
+    std::fill(cellStart_.begin(), cellStart_.end(), 0);
+    for (const Proxy &proxy: proxies_) {
+        for (uint32_t y = row(proxy.box.minY); y <= row(proxy.box.maxY); ++y)
+            for (uint32_t x = column(proxy.box.minX); x <= column(proxy.box.maxX); ++x)
+                cellStart_[y * columns_ + x + 1]++;
+    }
+    for (size_t c = 1; c < cellStart_.size(); ++c) cellStart_[c] += cellStart_[c - 1];
+    cellProxies_.resize(cellStart_.back());
+    cellBoxes_.resize(cellStart_.back());
+    fillCursor_.assign(cellStart_.begin(), cellStart_.end() - 1);
+    for (uint32_t i = 0; i < proxies_.size(); ++i) {
+        const AABB &box = proxies_[i].box;
+        for (uint32_t y = row(box.minY); y <= row(box.maxY); ++y) {
+            for (uint32_t x = column(box.minX); x <= column(box.maxX); ++x) {
+                uint32_t slot = fillCursor_[y * columns_ + x]++;
+                cellProxies_[slot] = i;
+                cellBoxes_.set(slot, box);
+            }
+        }
+    }
+
+    for (uint32_t cell = 0; cell + 1 < cellStart_.size(); ++cell) {
+        uint32_t cellEnd = cellStart_[cell + 1];
+        for (uint32_t i = cellStart_[cell]; i + 1 < cellEnd; ++i) {
+            const Proxy &a = proxies_[cellProxies_[i]];
+            // a against the rest of the cell in one go, then only the hits get looked at
+            AABBBatch rest = cellBoxes_.batch(i + 1, cellEnd - i - 1);
+            hitMask_.resize((rest.count + 63) / 64);
+            Collision::isCollidingBatch(a.box, rest, hitMask_.data());
+            for (uint32_t word = 0; word < hitMask_.size(); ++word) {
+                for (uint64_t bits = hitMask_[word]; bits; bits &= bits - 1) {
+                    uint32_t j = i + 1 + word * 64 + __builtin_ctzll(bits);
+                    const Proxy &b = proxies_[cellProxies_[j]];
+                    bool aWantsB = (a.mask & b.layer) != 0;
+                    bool bWantsA = (b.mask & a.layer) != 0;
+                    if (!aWantsB && !bWantsA) continue;
+
+                    // both share every cell the overlap touches, only its min corner's cell
+                    // reports
+                    uint32_t ownerCell = row(std::max(a.box.minY, b.box.minY)) * columns_ +
+                                         column(std::max(a.box.minX, b.box.minX));
+                    if (ownerCell != cell) continue;
+
+                    if (aWantsB) pairs_.push_back({a.userId, b.userId, a.layer, b.layer});
+                    else pairs_.push_back({b.userId, a.userId, b.layer, a.layer});
+                }
+            }
+        }
+    }
+    return pairs_;
+}
@@ -5,16 +5,123 @@
 #ifndef SPACEINVADERS3D_COLLISION_H
 #define SPACEINVADERS3D_COLLISION_H
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 struct AABB {
     float minX, minY;
     float maxX, maxY;
 };
 
+// A run of boxes stored as structure of arrays, what the batch tests read
+struct AABBBatch {
+    const float *minX, *minY, *maxX, *maxY;
+    uint32_t count;
+};
+
+// Owning SoA storage for AABBBatch
+struct AABBArray {
+    std::vector<float> minX, minY, maxX, maxY;
+
+    void clear();
+
+    void resize(size_t size);
+
+    void set(size_t index, const AABB &box);
+
+    void push(const AABB &box);
+
+    size_t size() const { return minX.size(); }
+
+    AABBBatch batch(uint32_t first, uint32_t count) const {
+        return {minX.data() + first, minY.data() + first, maxX.data() + first,
+                maxY.data() + first, count};
+    }
+};
+
 class Collision {
 public:
     static bool isColliding(const AABB& a, const AABB& b);
     static AABB getAABB(float cx, float cy, float width, float height);
 
+    // moving is where the box starts the step, (dx, dy) how far it goes, target stays put (pass
+    // the relative motion if both move). Returns true with timeOfImpact in [0, 1) if they overlap
+    // at any point of the step, 0 if they already did. No displacement = isColliding()
+    static bool sweep(const AABB &moving, float dx, float dy, const AABB &target,
+                      float &timeOfImpact);
+
+    // smallest box holding box at the start and the end of the step
+    static AABB sweptBounds(const AABB &box, float dx, float dy);
+
+    // box against every box of the batch: bit i of hitMask is set if box i overlaps.
+    // hitMask needs (count + 63) / 64 words. NEON, AVX or SSE when available, same result as
+    // isColliding() bit for bit either way
+    static void isCollidingBatch(const AABB &box, const AABBBatch &boxes, uint64_t *hitMask);
+
+    // scalar version of isCollidingBatch, kept as the reference the SIMD paths are checked against
+    static void isCollidingBatchScalar(const AABB &box, const AABBBatch &boxes,
+                                       uint64_t *hitMask);
+
+    // indices of the boxes hit, returns how many got written (at most boxes.count)
+    static uint32_t collidingIndices(const AABB &box, const AABBBatch &boxes, uint32_t *hits);
+
+};
+
+// What an entity is, as a bit so masks can name several at once
+enum CollisionLayer : uint32_t {
+    LayerShip = 1u << 0,
+    LayerShipBullet = 1u << 1,
+    LayerAlien = 1u << 2,
+    LayerAlienBullet = 1u << 3,
+    LayerPowerUp = 1u << 4
+};
+
+// Two overlapping proxies. first is the one whose mask asked for the other's layer
+struct CollisionPair {
+    uint32_t first, second; // user ids passed to Broadphase::add
+    CollisionLayer firstLayer, secondLayer;
+};
+
+// Uniform grid over NDC, rebuilt every tick: add() everything that moved, then findPairs().
+// Proxies outside the bounds land in the edge cells, so they still collide, just slower.
+// Each overlapping pair is reported once, by the cell that holds the corner of the overlap.
+class Broadphase {
+public:
+    explicit Broadphase(float cellSize = 0.125f, AABB bounds = {-1.25f, -1.25f, 1.25f, 1.25f});
+
+    void clear();
+
+    // mask = layers this proxy wants to hear about
+    void add(const AABB &box, CollisionLayer layer, uint32_t mask, uint32_t userId);
+
+    // overlapping pairs that pass the masks, valid until the next clear()
+    const std::vector<CollisionPair> &findPairs();
+
+    size_t proxyCount() const { return proxies_.size(); }
+
+private:
+    struct Proxy {
+        AABB box;
+        CollisionLayer layer;
+        uint32_t mask;
+        uint32_t userId;
+    };
+
+    AABB bounds_;
+    float invCellSize_;
+    uint32_t columns_, rows_;
+    std::vector<Proxy> proxies_;
+    std::vector<uint32_t> cellStart_;   // prefix sums, cell c owns [cellStart_[c], cellStart_[c+1])
+    std::vector<uint32_t> cellProxies_;
+    AABBArray cellBoxes_;               // cellProxies_' boxes in the same order, for batch tests
+    std::vector<uint64_t> hitMask_;
+    std::vector<uint32_t> fillCursor_;
+    std::vector<CollisionPair> pairs_;
+
+    uint32_t column(float x) const;
+
+    uint32_t row(float y) const;
 };
 
 
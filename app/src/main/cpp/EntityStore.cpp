@@ -0,0 +1,117 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "EntityStore.h"
+#include <algorithm>
+
+EntityStore::EntityStore(uint32_t capacity) {
+    position_.reserve(capacity);
+    prevPosition_.reserve(capacity);
+    velocity_.reserve(capacity);
+    extents_.reserve(capacity);
+    health_.reserve(capacity);
+    render_.reserve(capacity);
+    type_.reserve(capacity);
+    slotOf_.reserve(capacity);
+    slots_.reserve(capacity);
+    for (auto &bits: typeBits_) bits.reserve((capacity + 63) / 64);
+}
+
+uint32_t EntityStore::create(EntityType type, glm::vec2 position, glm::vec2 velocity,
+                             glm::vec2 extents, int health) {
+    uint32_t slot = freeSlot_;
+    if (slot == INVALID_INDEX) {
+        slot = uint32_t(slots_.size());
+        slots_.push_back({0, 0});
+    } else {
+        freeSlot_ = slots_[slot].index;
+    }
+    uint32_t index = size();
+    slots_[slot].index = index;
+
+    position_.push_back(position);
+    prevPosition_.push_back(position);
+    velocity_.push_back(velocity);
+    extents_.push_back(extents);
+    health_.push_back(health);
+    render_.push_back({});
+    type_.push_back(type);
+    slotOf_.push_back(slot);
+    if (index / 64 >= wordCount_) {
+        wordCount_++;
+        for (auto &bits: typeBits_) bits.push_back(0);
+    }
+    setTypeBit(index, type);
+    return index;
+}
+
+uint32_t EntityStore::indexOf(EntityHandle handle) const {
+    if (handle.index >= slots_.size()) return INVALID_INDEX;
+    const Slot &slot = slots_[handle.index];
+    // a free slot's index is the free list link, the generation check rules that out
+    if (slot.generation != handle.generation) return INVALID_INDEX;
+    return slot.index;
+}
+
+void EntityStore::destroy(EntityHandle handle) {
+    uint32_t index = indexOf(handle);
+    if (index != INVALID_INDEX) destroyAt(index);
+}
+
+void EntityStore::destroyAt(uint32_t index) {
+    uint32_t slot = slotOf_[index];
+    uint32_t last = size() - 1;
+    clearTypeBit(index, type_[index]);
+    if (index != last) {
+        clearTypeBit(last, type_[last]);
+        setTypeBit(index, type_[last]);
+        position_[index] = position_[last];
+        prevPosition_[index] = prevPosition_[last];
+        velocity_[index] = velocity_[last];
+        extents_[index] = extents_[last];
+        health_[index] = health_[last];
+        render_[index] = render_[last];
+        type_[index] = type_[last];
+        slotOf_[index] = slotOf_[last];
+        slots_[slotOf_[index]].index = index;
+    }
+    position_.pop_back();
+    prevPosition_.pop_back();
+    velocity_.pop_back();
+    extents_.pop_back();
+    health_.pop_back();
+    render_.pop_back();
+    type_.pop_back();
+    slotOf_.pop_back();
+
+    slots_[slot].generation++;
+    slots_[slot].index = freeSlot_;
+    freeSlot_ = slot;
+}
+
+void EntityStore::destroyLater(uint32_t index) {
+    pendingDestroy_.push_back(handle(index));
+}
+
+void EntityStore::flushDestroyed() {
+    // by handle, so it doesn't matter that every destroy shuffles the dense indices (or that
+    // something got queued twice)
+    for (EntityHandle handle: pendingDestroy_) destroy(handle);
+    pendingDestroy_.clear();
+}
+
+void EntityStore::clear() {
+    while (size() > 0) destroyAt(size() - 1);
+    pendingDestroy_.clear();
+}
+
+void EntityStore::integrate(float deltaTime) {
+    uint32_t count = size();
+    glm::vec2 *position = position_.data();
+    const glm::vec2 *velocity = velocity_.data();
+    std::copy(position, position + count, prevPosition_.data());
+    for (uint32_t i = 0; i < count; ++i) {
+        position[i] += velocity[i] * deltaTime;
+    }
+}
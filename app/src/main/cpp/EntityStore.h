@@ -0,0 +1,172 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_ENTITYSTORE_H
+#define SPACEINVADERS3D_ENTITYSTORE_H
+
+#include "GameObjectData.h"
+#include "Collision.h"
+
+enum class EntityType : uint8_t {
+    Ship,
+    ShipBullet,
+    AlienBullet,
+    DoubleShotPowerUp,
+    ShieldPowerUp
+};
+
+static constexpr uint32_t ENTITY_TYPE_COUNT = 5;
+
+constexpr uint32_t entityMask(EntityType type) { return 1u << uint32_t(type); }
+
+// Slot in the store's slot table + the generation it was handed out with. Once the entity is
+// destroyed the slot's generation moves on, so old handles just stop resolving
+struct EntityHandle {
+    uint32_t index{UINT32_MAX};
+    uint32_t generation{0};
+};
+
+// what the sprite batch needs besides the position
+struct EntityRender {
+    GameTextureType texture{GameTextureType::Ship};
+    glm::vec2 scale{1.0f};
+    bool pulse{false};
+};
+
+// Everything that moves and collides except the aliens (those are AlienFormation's grid).
+// Components live in dense arrays, [0, size()) are exactly the live entities so loops never
+// skip dead slots, and a bitset per type lets a pass visit just the types it cares about.
+// Destroying swaps the last entity into the hole: when destroying while walking the arrays,
+// walk backwards (forEach() does), or use destroyLater() + flushDestroyed().
+// Positions are in alien space (y up), sprites flip y when drawing.
+class EntityStore {
+public:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    // capacity is only the starting size, the pools grow when it runs out
+    explicit EntityStore(uint32_t capacity);
+
+    // new entity at the end of the pools with everything else zeroed, returns its dense index.
+    // Can reallocate, don't hold on to component references across it
+    uint32_t create(EntityType type, glm::vec2 position, glm::vec2 velocity, glm::vec2 extents,
+                    int health = 1);
+
+    void destroy(EntityHandle handle);
+
+    void destroyAt(uint32_t index);
+
+    // destroyed on the next flushDestroyed(), dense indices stay put until then
+    void destroyLater(uint32_t index);
+
+    void flushDestroyed();
+
+    void clear();
+
+    bool alive(EntityHandle handle) const { return indexOf(handle) != INVALID_INDEX; }
+
+    // dense index of the entity, INVALID_INDEX if it's gone
+    uint32_t indexOf(EntityHandle handle) const;
+
+    EntityHandle handle(uint32_t index) const {
+        uint32_t slot = slotOf_[index];
+        return {slot, slots_[slot].generation};
+    }
+
+    // fn(index) for every entity whose type is in typeMask (entityMask() bits), highest index
+    // first. Costs a word per 64 entities plus the matches, and fn may destroyAt(index): the
+    // entity swapped in comes from a higher index, which has been visited already
+    template<typename Fn>
+    void forEach(uint32_t typeMask, Fn &&fn) const {
+        for (uint32_t word = wordCount_; word-- > 0;) {
+            uint64_t bits = 0;
+            for (uint32_t type = 0; type < ENTITY_TYPE_COUNT; ++type) {
+                if (typeMask & (1u << type)) bits |= typeBits_[type][word];
+            }
+            while (bits) {
+                uint32_t bit = 63 - __builtin_clzll(bits);
+                bits &= ~(1ull << bit);
+                fn(word * 64 + bit);
+            }
+        }
+    }
+
+    // prevPosition = position, position += velocity * deltaTime for everyone
+    void integrate(float deltaTime);
+
+    uint32_t size() const { return uint32_t(type_.size()); }
+
+    uint32_t capacity() const { return uint32_t(type_.capacity()); }
+
+    EntityType type(uint32_t index) const { return type_[index]; }
+
+    glm::vec2 &position(uint32_t index) { return position_[index]; }
+
+    glm::vec2 position(uint32_t index) const { return position_[index]; }
+
+    glm::vec2 &prevPosition(uint32_t index) { return prevPosition_[index]; }
+
+    glm::vec2 &velocity(uint32_t index) { return velocity_[index]; }
+
+    glm::vec2 extents(uint32_t index) const { return extents_[index]; }
+
+    int &health(uint32_t index) { return health_[index]; }
+
+    EntityRender &render(uint32_t index) { return render_[index]; }
+
+    const EntityRender &render(uint32_t index) const { return render_[index]; }
+
+    // box at the current position
+    AABB bounds(uint32_t index) const {
+        return Collision::getAABB(position_[index].x, position_[index].y, extents_[index].x,
+                                  extents_[index].y);
+    }
+
+    // box where the last step started, sweep it by step() for the swept tests
+    AABB startBounds(uint32_t index) const {
+        return Collision::getAABB(prevPosition_[index].x, prevPosition_[index].y,
+                                  extents_[index].x, extents_[index].y);
+    }
+
+    glm::vec2 step(uint32_t index) const { return position_[index] - prevPosition_[index]; }
+
+    // between the last two integrate()s, for drawing at display rate (Time::alpha)
+    glm::vec2 interpolated(uint32_t index, float alpha) const {
+        return glm::mix(prevPosition_[index], position_[index], alpha);
+    }
+
+private:
+    struct Slot {
+        uint32_t index;      // dense index while alive, next free slot while free
+        uint32_t generation;
+    };
+
+    // hot, touched by integrate() and the collision pass
+    std::vector<glm::vec2> position_;
+    std::vector<glm::vec2> prevPosition_;
+    std::vector<glm::vec2> velocity_;
+    std::vector<glm::vec2> extents_;
+    // cold
+    std::vector<int> health_;
+    std::vector<EntityRender> render_;
+    std::vector<EntityType> type_;
+    std::vector<uint32_t> slotOf_;       // dense index -> slot
+    // bit i of typeBits_[t] = entity at dense index i is of type t
+    std::vector<uint64_t> typeBits_[ENTITY_TYPE_COUNT];
+    uint32_t wordCount_ = 0;             // of every bitset, never shrinks
+
+    std::vector<Slot> slots_;
+    uint32_t freeSlot_ = INVALID_INDEX;  // head of the free list threaded through slots_
+    std::vector<EntityHandle> pendingDestroy_;
+
+    void setTypeBit(uint32_t index, EntityType type) {
+        typeBits_[uint32_t(type)][index / 64] |= 1ull << (index % 64);
+    }
+
+    void clearTypeBit(uint32_t index, EntityType type) {
+        typeBits_[uint32_t(type)][index / 64] &= ~(1ull << (index % 64));
+    }
+};
+
+
+#endif //SPACEINVADERS3D_ENTITYSTORE_H
@@ -16,7 +16,6 @@
 #include <sstream>
 #include "GameObjectData.h"
 
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "Vulkan", __VA_ARGS__)
 
 struct FontGlyphMetrics {
     int minX, maxX;      // Left/right of nontransparent region (relative to cell)
@@ -0,0 +1,31 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_FRAMESNAPSHOT_H
+#define SPACEINVADERS3D_FRAMESNAPSHOT_H
+
+#include "GameObjectData.h"
+#include "SpriteBatch.h"
+#include "ParticleSystem.h"
+
+// Everything recording a frame needs from the game, copied out once the game thread is done with
+// the frame. The render thread only reads this (plus GPU resources that don't change after init),
+// so it never looks at live game state.
+struct FrameSnapshot {
+    SpriteBatch sprites;
+    std::vector<ParticleInstance> particles;
+    std::vector<StarInstance> stars;          // empty with procedural stars
+    StarFieldPushConstants starField{};
+    ShieldInstance halo{};
+    bool haloVisible = false;
+    std::vector<Vertex> scoreText;
+    GameState gameState = GameState::Playing;
+    // explosions for GpuParticles, every snapshot is recorded exactly once so none get lost
+    std::vector<ParticleEmit> gpuEmits;
+    // wall clock time this frame covers, for what's simulated while recording (GPU particles)
+    float deltaTime = 0.0f;
+};
+
+
+#endif //SPACEINVADERS3D_FRAMESNAPSHOT_H
@@ -5,15 +5,21 @@
 #ifndef SPACEINVADERS3D_GAMEOBJECTDATA_H
 #define SPACEINVADERS3D_GAMEOBJECTDATA_H
 
+#ifdef __ANDROID__
 #define VK_USE_PLATFORM_ANDROID_KHR
 
 #include <android_native_app_glue.h>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_android.h>
 //#include <volk.h>
-#include <vector>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
+#else
+// desktop build (headless renderer), no window system
+#include <vulkan/vulkan.h>
+#include <cstdio>
+#include <cstring>
+#endif
 #include <vector>
 
 #define GLM_FORCE_RADIANS
@@ -27,14 +33,18 @@
 
 #include <glm/gtx/hash.hpp>
 #include <glm/glm.hpp>
-#include <android/log.h>
 #include <chrono>
 #include <unordered_map>
 #include <random>
 #include <cmath>
 #include <utility>
 
+#ifdef __ANDROID__
+#include <android/log.h>
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "Vulkan", __VA_ARGS__)
+#else
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
 constexpr int MAX_POWERUPS = 10;
 
 
@@ -77,16 +87,8 @@ enum class BulletType {
     Alien
 };
 
-struct Bullet {
-    float x{}, y{};
-    bool active{};
-    std::array<float, 2> widthHeight{};
-    BulletType bulletType{};
-    const float size = 0.05f * 0.5f; //half alien
-};
-
+// position lives in AlienFormation
 struct Alien {
-    float x{}, y{};
     bool active{};
     std::array<float, 2> widthHeight{};
     uint hp{3};
@@ -99,16 +101,17 @@ enum class PowerUpType {
 };
 
 
-struct Ship {
-    float x{}, y{};
-    float color[3]{};
-    std::array<float, 2> widthHeight{};
-    uint hp{3};
-    float size{0.1f};
-};
 
+// Where a sprite texture lives in the sprite texture array: layer + the part of it that's used,
+// as {offset.x, offset.y, scale.x, scale.y} applied to the quad's uvs.
+struct SpriteRegion {
+    uint layer{0};
+    glm::vec4 uvRect{0.0f, 0.0f, 1.0f, 1.0f};
+};
 
-struct MainPushConstants {
+// Per-instance data for everything drawn with the main pipeline (ship, aliens, bullets, power-ups).
+// Used to be push constants, now one instanced draw covers every sprite.
+struct SpriteInstance {
     glm::vec2 pos{0.0f, 0.0f};
     glm::vec2 shakeOffset{0.0f, 0.0f};
     float flashAmount{0.0f};
@@ -116,6 +119,39 @@ struct MainPushConstants {
     float time{0.0f};
     uint canPulse{0};
     glm::vec2 scale{1.0f, 1.0f};
+    glm::vec4 uvRect{0.0f, 0.0f, 1.0f, 1.0f};
+
+    void setTexture(const SpriteRegion &region) {
+        texturePos = region.layer;
+        uvRect = region.uvRect;
+    }
+
+    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions() {
+        std::vector<VkVertexInputBindingDescription> bindings = {
+                {0, sizeof(Vertex),         VK_VERTEX_INPUT_RATE_VERTEX},   // shared sprite quad
+                {1, sizeof(SpriteInstance), VK_VERTEX_INPUT_RATE_INSTANCE}  // one per sprite
+        };
+        return bindings;
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributes = {
+                // Quad vertex (locations 0-2)
+                {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
+                {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)},
+                {2, 0, VK_FORMAT_R32G32_SFLOAT,    offsetof(Vertex, uv)},
+                // Instance data (locations 3-10)
+                {3, 1, VK_FORMAT_R32G32_SFLOAT,    offsetof(SpriteInstance, pos)},
+                {4, 1, VK_FORMAT_R32G32_SFLOAT,    offsetof(SpriteInstance, shakeOffset)},
+                {5, 1, VK_FORMAT_R32_SFLOAT,       offsetof(SpriteInstance, flashAmount)},
+                {6, 1, VK_FORMAT_R32_UINT,         offsetof(SpriteInstance, texturePos)},
+                {7, 1, VK_FORMAT_R32_SFLOAT,       offsetof(SpriteInstance, time)},
+                {8, 1, VK_FORMAT_R32_UINT,         offsetof(SpriteInstance, canPulse)},
+                {9, 1, VK_FORMAT_R32G32_SFLOAT,    offsetof(SpriteInstance, scale)},
+                {10, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(SpriteInstance, uvRect)}
+        };
+        return attributes;
+    }
 };
 
 
@@ -135,6 +171,7 @@ struct GfxPipelineData {
     VkViewport viewport;
     VkRect2D scissor;
     VkPipelineColorBlendAttachmentState colorBlendAttachment;
+    uint64_t shaderHash{0}; // of the SPIR-V in shaderStages, for the pipeline registry
 };
 
 enum class GameState {
@@ -154,7 +191,8 @@ enum class GameTextureType {
     ShipBullet,
     FontAtlas,
     Overlay,
-    PowerUp
+    DoubleShot,
+    Shield
 };
 // Graphics pipeline types
 enum class GfxPipelineType {
@@ -164,7 +202,9 @@ enum class GfxPipelineType {
     ExplosionParticles,
     StarParticles,
     AxisAlignedBoundingBoxes,
-    HaloEffect
+    HaloEffect,
+    GpuExplosionParticles,
+    ProceduralStars
 };
 
 
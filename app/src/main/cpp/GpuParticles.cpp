@@ -0,0 +1,245 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "GpuParticles.h"
+#include <algorithm>
+#include <stdexcept>
+
+GpuParticles::GpuParticles(VkDevice device, MemoryAllocator &allocator,
+                           VkPipelineCache pipelineCache, ShaderModuleCache &shaderModules,
+                           uint32_t capacity)
+        : device_(device), allocator_(allocator), capacity_(capacity) {
+    for (int side = 0; side < 2; ++side) {
+        createBuffer(VkDeviceSize(capacity_) * sizeof(GpuParticle),
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                     particleBuffers_[side], particleMemory_[side]);
+    }
+    createBuffer(2 * sizeof(VkDrawIndexedIndirectCommand),
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                 VK_BUFFER_USAGE_TRANSFER_DST_BIT, drawBuffer_, drawMemory_);
+    createDescriptors();
+    createPipeline(pipelineCache, shaderModules);
+    LOGE("GPU particles: %u max, %.1f MiB of state", capacity_,
+         2.0 * capacity_ * sizeof(GpuParticle) / (1024.0 * 1024.0));
+}
+
+GpuParticles::~GpuParticles() {
+    vkDestroyPipeline(device_, pipeline_, nullptr);
+    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+    vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+    for (int side = 0; side < 2; ++side) {
+        vkDestroyBuffer(device_, particleBuffers_[side], nullptr);
+        allocator_.free(particleMemory_[side]);
+    }
+    vkDestroyBuffer(device_, drawBuffer_, nullptr);
+    allocator_.free(drawMemory_);
+}
+
+bool GpuParticles::supported(VkPhysicalDevice physicalDevice, uint32_t queueFamily) {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    return queueFamily < familyCount && (families[queueFamily].queueFlags & VK_QUEUE_COMPUTE_BIT);
+}
+
+void GpuParticles::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer,
+                                MemoryAllocation &memory) {
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        LOGE("Failed to create GPU particle buffer");
+        throw std::runtime_error("Failed to create GPU particle buffer");
+    }
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+    memory = allocator_.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    vkBindBufferMemory(device_, buffer, memory.memory, memory.offset);
+}
+
+void GpuParticles::createDescriptors() {
+    VkDescriptorSetLayoutBinding bindings[3] = {};
+    for (uint32_t i = 0; i < 3; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 3;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &descriptorSetLayout_) !=
+        VK_SUCCESS) {
+        LOGE("Failed to create GPU particle descriptor set layout");
+        throw std::runtime_error("Failed to create descriptor layout");
+    }
+
+    VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6};
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 2;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS) {
+        LOGE("Failed to create GPU particle descriptor pool");
+        throw std::runtime_error("Failed to create descriptor pool");
+    }
+
+    VkDescriptorSetLayout setLayouts[2] = {descriptorSetLayout_, descriptorSetLayout_};
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool_;
+    allocInfo.descriptorSetCount = 2;
+    allocInfo.pSetLayouts = setLayouts;
+    if (vkAllocateDescriptorSets(device_, &allocInfo, descriptorSets_) != VK_SUCCESS) {
+        LOGE("Failed to allocate GPU particle descriptor sets");
+        throw std::runtime_error("Failed to create descriptor set");
+    }
+
+    for (uint32_t side = 0; side < 2; ++side) {
+        VkDescriptorBufferInfo bufferInfos[3] = {
+                {particleBuffers_[side],     0, VK_WHOLE_SIZE},
+                {particleBuffers_[1 - side], 0, VK_WHOLE_SIZE},
+                {drawBuffer_,                0, VK_WHOLE_SIZE}};
+        VkWriteDescriptorSet writes[3] = {};
+        for (uint32_t i = 0; i < 3; ++i) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = descriptorSets_[side];
+            writes[i].dstBinding = i;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].descriptorCount = 1;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(device_, 3, writes, 0, nullptr);
+    }
+}
+
+void GpuParticles::createPipeline(VkPipelineCache pipelineCache,
+                                  ShaderModuleCache &shaderModules) {
+    VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                             sizeof(PushConstants)};
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSetLayout_;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device_, &layoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS) {
+        LOGE("Failed to create GPU particle pipeline layout");
+        throw std::runtime_error("Failed to create pipeline layout");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModules.get("particles_simulate.comp.spv").module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout_;
+    VkResult res = vkCreateComputePipelines(device_, pipelineCache, 1, &pipelineInfo, nullptr,
+                                            &pipeline_);
+    if (res != VK_SUCCESS) {
+        LOGE("Failed to create GPU particle pipeline! error code:%d", res);
+        throw std::runtime_error("Failed to create compute pipeline");
+    }
+}
+
+void GpuParticles::emit(const glm::vec3 &position, uint32_t count) {
+    if (count == 0) return;
+    pendingEmits_.push_back({glm::vec2(position), std::min(count, capacity_), nextSeed_});
+    nextSeed_ = nextSeed_ * 747796405u + 2891336453u;
+}
+
+void GpuParticles::recordSimulation(VkCommandBuffer cmd, float deltaTime) {
+    uint32_t dstSide = 1 - srcSide_;
+    VkDeviceSize dstCountOffset = dstSide * sizeof(VkDrawIndexedIndirectCommand) +
+                                  offsetof(VkDrawIndexedIndirectCommand, instanceCount);
+
+    // last frame's draw may still be reading what this pass is about to overwrite
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                            VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    if (!drawBufferInitialized_) {
+        VkDrawIndexedIndirectCommand draws[2] = {{6, 0, 0, 0, 0},
+                                                 {6, 0, 0, 0, 0}};
+        vkCmdUpdateBuffer(cmd, drawBuffer_, 0, sizeof(draws), draws);
+        drawBufferInitialized_ = true;
+    } else {
+        vkCmdFillBuffer(cmd, drawBuffer_, dstCountOffset, sizeof(uint32_t), 0);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                         nullptr);
+
+    PushConstants push = {};
+    push.deltaTime = deltaTime;
+    push.capacity = capacity_;
+    push.srcSide = srcSide_;
+    uint32_t emitTotal = 0;
+    while (!pendingEmits_.empty() && push.emitCount < MAX_EMITS_PER_FRAME &&
+           emitTotal + pendingEmits_.front().count <= capacity_) {
+        push.emits[push.emitCount++] = pendingEmits_.front();
+        emitTotal += pendingEmits_.front().count;
+        pendingEmits_.pop_front();
+    }
+
+    // nothing outlives MAX_LIFE, so the emits of the last MAX_LIFE seconds bound the live count
+    // and the dispatch doesn't have to cover the whole buffer every frame
+    uint32_t aliveBound = emitTotal;
+    for (auto it = recentEmits_.begin(); it != recentEmits_.end();) {
+        it->first += deltaTime;
+        if (it->first > MAX_LIFE + 0.05f) { // a little slack for float drift vs the shader
+            it = recentEmits_.erase(it);
+        } else {
+            aliveBound += it->second;
+            ++it;
+        }
+    }
+    if (emitTotal) recentEmits_.emplace_back(0.0f, emitTotal);
+    aliveBound = std::min(aliveBound, capacity_);
+
+    if (aliveBound > 0) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_, 0, 1,
+                                &descriptorSets_[srcSide_], 0, nullptr);
+        vkCmdPushConstants(cmd, pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push),
+                           &push);
+        vkCmdDispatch(cmd, (aliveBound + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                            VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+    srcSide_ = dstSide;
+}
+
+void GpuParticles::recordDraw(VkCommandBuffer cmd, VkPipeline pipeline,
+                              VkBuffer quadVertexBuffer, VkBuffer quadIndexBuffer) const {
+    // recordSimulation() already flipped, srcSide_ is what it just wrote
+    VkBuffer vertexBuffers[] = {quadVertexBuffer, particleBuffers_[srcSide_]};
+    VkDeviceSize offsets[] = {0, 0};
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindVertexBuffers(cmd, 0, 2, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(cmd, quadIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+    vkCmdDrawIndexedIndirect(cmd, drawBuffer_, srcSide_ * sizeof(VkDrawIndexedIndirectCommand),
+                             1, sizeof(VkDrawIndexedIndirectCommand));
+}
@@ -0,0 +1,119 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_GPUPARTICLES_H
+#define SPACEINVADERS3D_GPUPARTICLES_H
+
+#include "GameObjectData.h"
+#include "MemoryAllocator.h"
+#include "ShaderModuleCache.h"
+#include <deque>
+
+// one particle as the compute shader sees it (std430), also read by the draw as instance data
+struct GpuParticle {
+    glm::vec3 center;
+    float size;
+    glm::vec2 velocity;
+    float life;
+    float maxLife;
+    glm::vec4 color;
+
+    // same attribute locations as ParticleInstance so particles_instanced.vert works unchanged
+    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions() {
+        return {
+                {0, sizeof(Vertex),      VK_VERTEX_INPUT_RATE_VERTEX},
+                {1, sizeof(GpuParticle), VK_VERTEX_INPUT_RATE_INSTANCE}
+        };
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+        return {
+                {0, 0, VK_FORMAT_R32G32B32_SFLOAT,    offsetof(Vertex, pos)},
+                {1, 1, VK_FORMAT_R32G32B32_SFLOAT,    offsetof(GpuParticle, center)},
+                {2, 1, VK_FORMAT_R32_SFLOAT,          offsetof(GpuParticle, size)},
+                {3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(GpuParticle, color)}
+        };
+    }
+};
+
+static_assert(sizeof(GpuParticle) == 48, "GpuParticle has to match the std430 struct");
+
+// Explosion particles that live on the GPU. Two state buffers ping-pong: a compute pass
+// integrates last frame's buffer, compacts the survivors into the other one and appends new
+// emits. The survivor count is written straight into a VkDrawIndexedIndirectCommand, so nothing
+// is uploaded or read back per frame except the emit requests (push constants).
+class GpuParticles {
+public:
+    static constexpr uint32_t MAX_EMITS_PER_FRAME = 7; // fills the 128 byte push constant budget
+    static constexpr uint32_t WORKGROUP_SIZE = 64;
+    static constexpr float MAX_LIFE = 0.8f; // keep in sync with particles_simulate.comp
+
+    GpuParticles(VkDevice device, MemoryAllocator &allocator, VkPipelineCache pipelineCache,
+                 ShaderModuleCache &shaderModules, uint32_t capacity);
+
+    ~GpuParticles();
+
+    // the queue that records the compute pass has to support compute
+    static bool supported(VkPhysicalDevice physicalDevice, uint32_t queueFamily);
+
+    // queued, goes out with the next recordSimulation() (or a later one if that one is full)
+    void emit(const glm::vec3 &position, uint32_t count);
+
+    // outside a render pass, before recordDraw() in the same command buffer
+    void recordSimulation(VkCommandBuffer cmd, float deltaTime);
+
+    void recordDraw(VkCommandBuffer cmd, VkPipeline pipeline, VkBuffer quadVertexBuffer,
+                    VkBuffer quadIndexBuffer) const;
+
+    uint32_t capacity() const { return capacity_; }
+
+private:
+    struct EmitRequest {
+        glm::vec2 position;
+        uint32_t count;
+        uint32_t seed;
+    };
+
+    struct PushConstants {
+        float deltaTime;
+        uint32_t capacity;
+        uint32_t srcSide;
+        uint32_t emitCount;
+        EmitRequest emits[MAX_EMITS_PER_FRAME];
+    };
+
+    static_assert(sizeof(PushConstants) <= 128, "push constants past the guaranteed minimum");
+
+    VkDevice device_{VK_NULL_HANDLE};
+    MemoryAllocator &allocator_;
+    uint32_t capacity_ = 0;
+
+    VkBuffer particleBuffers_[2]{};
+    MemoryAllocation particleMemory_[2];
+    VkBuffer drawBuffer_{VK_NULL_HANDLE}; // VkDrawIndexedIndirectCommand per side
+    MemoryAllocation drawMemory_;
+
+    VkDescriptorSetLayout descriptorSetLayout_{VK_NULL_HANDLE};
+    VkDescriptorPool descriptorPool_{VK_NULL_HANDLE};
+    VkDescriptorSet descriptorSets_[2]{}; // [n] reads side n, writes side 1 - n
+    VkPipelineLayout pipelineLayout_{VK_NULL_HANDLE};
+    VkPipeline pipeline_{VK_NULL_HANDLE};
+
+    uint32_t srcSide_ = 0;
+    bool drawBufferInitialized_ = false;
+    uint32_t nextSeed_ = 1;
+    std::deque<EmitRequest> pendingEmits_;
+    // emits still possibly alive, their sum bounds how many threads the dispatch needs
+    std::deque<std::pair<float, uint32_t>> recentEmits_;
+
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer,
+                      MemoryAllocation &memory);
+
+    void createDescriptors();
+
+    void createPipeline(VkPipelineCache pipelineCache, ShaderModuleCache &shaderModules);
+};
+
+
+#endif //SPACEINVADERS3D_GPUPARTICLES_H
@@ -0,0 +1,284 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "JobSystem.h"
+#include "GameObjectData.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// idle rounds a worker yields for before it goes to sleep. Frames hand out work in bursts a few
+// hundred microseconds apart, waking from a futex costs about as much as a small job
+static constexpr uint32_t SPIN_ROUNDS = 64;
+// parallelFor chunks per thread, so one thread getting descheduled doesn't hold up the rest
+static constexpr uint32_t CHUNKS_PER_THREAD = 4;
+
+// which system (if any) the calling thread is a worker of, and its queue
+static thread_local const JobSystem *currentSystem = nullptr;
+static thread_local uint32_t currentQueue = 0;
+
+JobGraph::JobId JobGraph::add(const char *name, std::function<void()> fn,
+                              std::initializer_list<JobId> dependencies) {
+    JobId id = size();
+    nodes_.push_back({name, std::move(fn), uint32_t(dependencies.size()), {}});
+    for (JobId dependency: dependencies) nodes_[dependency].dependents.push_back(id);
+    return id;
+}
+
+struct JobSystem::GraphRun {
+    JobSystem *jobs;
+    JobGraph *graph;
+    std::atomic<uint32_t> pending;
+};
+
+struct JobSystem::ForRun {
+    const std::function<void(uint32_t, uint32_t)> *fn;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t chunk;
+    std::atomic<uint32_t> pending;
+};
+
+JobSystem::JobSystem(uint32_t workerCount, bool pinWorkers)
+        : workerCount_(workerCount),
+          queues_(new Queue[workerCount + 1]) {
+    std::vector<uint32_t> cores;
+    if (pinWorkers) cores = coresByCapacity();
+    workers_.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        int core = cores.empty() ? -1 : int(cores[(i + 1) % cores.size()]);
+        workers_.emplace_back(&JobSystem::workerLoop, this, i, core);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    sleepWake_.notify_all();
+    for (auto &worker: workers_) worker.join();
+}
+
+void JobSystem::run(JobGraph &graph) {
+    uint32_t count = graph.size();
+    if (count == 0) return;
+    if (graph.remainingCapacity_ < count) {
+        graph.remaining_.reset(new std::atomic<uint32_t>[count]);
+        graph.remainingCapacity_ = count;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        graph.remaining_[i].store(graph.nodes_[i].dependencyCount, std::memory_order_relaxed);
+    }
+
+    GraphRun state{this, &graph, {count}};
+    uint32_t ready = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (graph.nodes_[i].dependencyCount > 0) continue;
+        push({runGraphJob, &state, i});
+        ready++;
+    }
+    wakeWorkers(ready);
+    helpUntilDone(state.pending);
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t grain,
+                            const std::function<void(uint32_t, uint32_t)> &fn) {
+    if (end <= begin) return;
+    uint32_t count = end - begin;
+    grain = std::max(grain, 1u);
+    uint32_t chunks = std::min((count + grain - 1) / grain, threadCount() * CHUNKS_PER_THREAD);
+    if (workerCount_ == 0 || chunks <= 1) {
+        fn(begin, end);
+        return;
+    }
+    uint32_t chunk = ((count + chunks - 1) / chunks + grain - 1) / grain * grain;
+    chunks = (count + chunk - 1) / chunk;
+
+    ForRun state{&fn, begin, end, chunk, {chunks}};
+    for (uint32_t i = 1; i < chunks; ++i) push({runForChunk, &state, i});
+    wakeWorkers(chunks - 1);
+    runForChunk(&state, 0);
+    helpUntilDone(state.pending);
+}
+
+uint32_t JobSystem::defaultWorkerCount() {
+    std::vector<uint32_t> capacities;
+    std::vector<uint32_t> cores = coresByCapacity(&capacities);
+    uint32_t fast = std::max(1u, std::thread::hardware_concurrency());
+    if (!cores.empty()) {
+        // all one cluster = everything counts
+        uint32_t slowest = capacities.back();
+        fast = uint32_t(std::count_if(capacities.begin(), capacities.end(),
+                                      [slowest](uint32_t c) { return c > slowest; }));
+        if (fast == 0) fast = uint32_t(cores.size());
+    }
+    return fast - 1;
+}
+
+static bool readCpuValues(const char *file, uint32_t cpuCount, std::vector<uint32_t> &values) {
+    values.assign(cpuCount, 0);
+    for (uint32_t cpu = 0; cpu < cpuCount; ++cpu) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/%s", cpu, file);
+        FILE *in = fopen(path, "r");
+        if (!in) return false;
+        bool ok = fscanf(in, "%u", &values[cpu]) == 1;
+        fclose(in);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+std::vector<uint32_t> JobSystem::coresByCapacity(std::vector<uint32_t> *capacities) {
+    uint32_t cpuCount = std::thread::hardware_concurrency();
+    std::vector<uint32_t> values;
+    // cpu_capacity is the scheduler's own idea of big vs little (arm64), the max clock is the
+    // next best guess elsewhere
+    if (cpuCount == 0 || (!readCpuValues("cpu_capacity", cpuCount, values) &&
+                          !readCpuValues("cpufreq/cpuinfo_max_freq", cpuCount, values))) {
+        if (capacities) capacities->clear();
+        return {};
+    }
+    std::vector<uint32_t> cores(cpuCount);
+    std::iota(cores.begin(), cores.end(), 0u);
+    std::stable_sort(cores.begin(), cores.end(),
+                     [&values](uint32_t a, uint32_t b) { return values[a] > values[b]; });
+    if (capacities) {
+        capacities->clear();
+        for (uint32_t core: cores) capacities->push_back(values[core]);
+    }
+    return cores;
+}
+
+uint32_t JobSystem::queueIndex() const {
+    return currentSystem == this ? currentQueue : workerCount_;
+}
+
+void JobSystem::push(const Task &task) {
+    Queue &queue = queues_[queueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    queued_.fetch_add(1);
+}
+
+void JobSystem::wakeWorkers(uint32_t count) {
+    // seq_cst against the sleeping_ increment in workerLoop: either we see the sleeper here, or
+    // it sees queued_ > 0 before it waits
+    if (count == 0 || sleeping_.load() == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    if (count == 1) {
+        sleepWake_.notify_one();
+    } else {
+        sleepWake_.notify_all();
+    }
+}
+
+bool JobSystem::tryRunOne(uint32_t queue) {
+    if (queued_.load(std::memory_order_relaxed) == 0) return false;
+    Task task{};
+    bool found = false;
+    {
+        Queue &own = queues_[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    uint32_t queueCount = workerCount_ + 1;
+    for (uint32_t i = 1; !found && i < queueCount; ++i) {
+        Queue &victim = queues_[(queue + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        // oldest first, those are the biggest pieces of a split up range
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+        found = true;
+        steals_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!found) return false;
+    queued_.fetch_sub(1);
+    task.fn(task.context, task.index);
+    return true;
+}
+
+void JobSystem::helpUntilDone(const std::atomic<uint32_t> &pending) {
+    uint32_t queue = queueIndex();
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!tryRunOne(queue)) std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(uint32_t index, int core) {
+    currentSystem = this;
+    currentQueue = index;
+    Trace::setThreadName("job worker");
+#ifdef __linux__
+    if (core >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+            LOGE("JobSystem: couldn't pin worker %u to cpu %d", index, core);
+    }
+#else
+    (void) core;
+#endif
+    uint32_t idle = 0;
+    while (true) {
+        if (tryRunOne(index)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < SPIN_ROUNDS) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle = 0;
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleeping_.fetch_add(1);
+        sleepWake_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+        sleeping_.fetch_sub(1);
+        // nothing is queued by the time the destructor runs, run()/parallelFor() wait for theirs
+        if (stopping_) return;
+    }
+}
+
+void JobSystem::runGraphJob(void *context, uint32_t index) {
+    GraphRun &run = *static_cast<GraphRun *>(context);
+    JobGraph &graph = *run.graph;
+    JobGraph::Node &node = graph.nodes_[index];
+    {
+        Trace::Zone zone(node.name);
+        node.fn();
+    }
+    uint32_t ready = 0;
+    for (JobGraph::JobId dependent: node.dependents) {
+        if (graph.remaining_[dependent].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+        run.jobs->push({runGraphJob, &run, dependent});
+        ready++;
+    }
+    // this thread picks one of them up itself straight away
+    if (ready > 1) run.jobs->wakeWorkers(ready - 1);
+    // last touch, run() returns (and run goes away) once this hits 0
+    run.pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::runForChunk(void *context, uint32_t index) {
+    ForRun &run = *static_cast<ForRun *>(context);
+    uint32_t first = run.begin + index * run.chunk;
+    (*run.fn)(first, std::min(first + run.chunk, run.end));
+    run.pending.fetch_sub(1, std::memory_order_release);
+}
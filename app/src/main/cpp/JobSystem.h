@@ -0,0 +1,136 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_JOBSYSTEM_H
+#define SPACEINVADERS3D_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Jobs plus what each one has to wait for, built on one thread and handed to JobSystem::run().
+// Reusable: clear() it and add() again next frame, the node array keeps its capacity
+class JobGraph {
+public:
+    using JobId = uint32_t;
+
+    // dependencies are ids add() already handed out, so a graph can't have cycles. name has to
+    // be a string literal, it becomes the job's trace zone
+    JobId add(const char *name, std::function<void()> fn,
+              std::initializer_list<JobId> dependencies = {});
+
+    void clear() { nodes_.clear(); }
+
+    uint32_t size() const { return uint32_t(nodes_.size()); }
+
+private:
+    friend class JobSystem;
+
+    struct Node {
+        const char *name;
+        std::function<void()> fn;
+        uint32_t dependencyCount;
+        std::vector<JobId> dependents;
+    };
+
+    std::vector<Node> nodes_;
+    // per node, dependencies still running during run()
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining_;
+    uint32_t remainingCapacity_ = 0;
+};
+
+// Small work stealing scheduler. Every worker has its own queue: it pushes and pops at the back
+// (newest first, still warm in cache) and idle threads steal from the front of someone else's.
+// The thread calling run()/parallelFor() works through the jobs too instead of just blocking,
+// so a system with 0 workers simply runs everything inline, and jobs can call parallelFor()
+// themselves without deadlocking. Jobs must not throw.
+class JobSystem {
+public:
+    // workerCount doesn't include the calling thread. pinWorkers ties worker i to the i+1th
+    // fastest core (the fastest is left for the game thread), Linux/Android only
+    explicit JobSystem(uint32_t workerCount = defaultWorkerCount(), bool pinWorkers = false);
+
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // runs the whole graph, returns once every job finished
+    void run(JobGraph &graph);
+
+    // fn(first, last) over [begin, end) split into chunks that are whole multiples of grain
+    // (bar the last one), returns once all of them ran
+    void parallelFor(uint32_t begin, uint32_t end, uint32_t grain,
+                     const std::function<void(uint32_t, uint32_t)> &fn);
+
+    uint32_t workerCount() const { return workerCount_; }
+
+    // workers + the calling thread
+    uint32_t threadCount() const { return workerCount_ + 1; }
+
+    // jobs taken from another thread's queue since startup
+    uint64_t stealCount() const { return steals_.load(std::memory_order_relaxed); }
+
+    // On big.LITTLE only the big cores count (everything faster than the slowest cluster), the
+    // little ones would just make the frame wait on a straggler. Minus one for the game thread
+    static uint32_t defaultWorkerCount();
+
+    // cpu ids, fastest first by cpu_capacity (or cpuinfo_max_freq), empty if sysfs won't say
+    static std::vector<uint32_t> coresByCapacity(std::vector<uint32_t> *capacities = nullptr);
+
+private:
+    struct Task {
+        void (*fn)(void *context, uint32_t index);
+        void *context;
+        uint32_t index;
+    };
+
+    // own cache line each, workers hammer their own queue's mutex
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    uint32_t workerCount_;
+    // one per worker + a shared one for threads that aren't workers
+    std::unique_ptr<Queue[]> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<uint32_t> queued_{0};
+    std::atomic<uint32_t> sleeping_{0};
+    std::atomic<uint64_t> steals_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable sleepWake_;
+    bool stopping_ = false;   // guarded by sleepMutex_
+
+    struct GraphRun;
+    struct ForRun;
+
+    uint32_t queueIndex() const;
+
+    void push(const Task &task);
+
+    void wakeWorkers(uint32_t count);
+
+    bool tryRunOne(uint32_t queue);
+
+    // runs jobs until pending drops to 0
+    void helpUntilDone(const std::atomic<uint32_t> &pending);
+
+    void workerLoop(uint32_t index, int core);
+
+    static void runGraphJob(void *context, uint32_t index);
+
+    static void runForChunk(void *context, uint32_t index);
+};
+
+
+#endif //SPACEINVADERS3D_JOBSYSTEM_H
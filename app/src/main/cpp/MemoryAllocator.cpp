@@ -0,0 +1,212 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "MemoryAllocator.h"
+#include <stdexcept>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice,
+                                 VkDeviceSize deviceLocalBlockSize,
+                                 VkDeviceSize hostVisibleBlockSize)
+        : device_(device), deviceLocalBlockSize_(deviceLocalBlockSize),
+          hostVisibleBlockSize_(hostVisibleBlockSize) {
+    // queried once instead of on every createBuffer/createImage
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties_);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    maxAllocationCount_ = properties.limits.maxMemoryAllocationCount;
+}
+
+MemoryAllocator::~MemoryAllocator() {
+    for (auto &block: blocks_) {
+        if (!block) continue;
+        if (block->mapped) vkUnmapMemory(device_, block->memory);
+        vkFreeMemory(device_, block->memory, nullptr);
+    }
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t typeBits,
+                                         VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++) {
+        if ((typeBits & (1 << i)) &&
+            (memoryProperties_.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    LOGE("No memory type for bits 0x%x, properties 0x%x", typeBits, properties);
+    throw std::runtime_error("Failed to find suitable memory type");
+}
+
+uint32_t MemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool linear,
+                                      bool dedicated) {
+    if (liveDeviceAllocations_ + 1 > maxAllocationCount_) {
+        LOGE("maxMemoryAllocationCount (%u) reached", maxAllocationCount_);
+        throw std::runtime_error("Too many device memory allocations");
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    auto block = std::make_unique<Block>();
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+        LOGE("Failed to allocate %llu bytes of device memory (type %u)",
+             (unsigned long long) size, memoryTypeIndex);
+        throw std::runtime_error("Failed to allocate device memory");
+    }
+    liveDeviceAllocations_++;
+
+    if (memoryProperties_.memoryTypes[memoryTypeIndex].propertyFlags &
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        void *data;
+        vkMapMemory(device_, block->memory, 0, VK_WHOLE_SIZE, 0, &data);
+        block->mapped = static_cast<uint8_t *>(data);
+    }
+    block->size = size;
+    block->memoryTypeIndex = memoryTypeIndex;
+    block->linear = linear;
+    block->dedicated = dedicated;
+    block->freeRanges.push_back({0, size});
+
+    // reuse a hole left by a released dedicated allocation if there is one
+    for (uint32_t i = 0; i < blocks_.size(); ++i) {
+        if (!blocks_[i]) {
+            blocks_[i] = std::move(block);
+            return i;
+        }
+    }
+    blocks_.push_back(std::move(block));
+    return static_cast<uint32_t>(blocks_.size() - 1);
+}
+
+bool MemoryAllocator::allocateFromBlock(uint32_t blockIndex,
+                                        const VkMemoryRequirements &requirements,
+                                        MemoryAllocation &allocation) {
+    Block &block = *blocks_[blockIndex];
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+    // first fit, the allocation count here is small enough that anything fancier isn't worth it
+    for (size_t i = 0; i < block.freeRanges.size(); ++i) {
+        Range &range = block.freeRanges[i];
+        VkDeviceSize alignedOffset = alignUp(range.offset, alignment);
+        VkDeviceSize padding = alignedOffset - range.offset;
+        if (padding + requirements.size > range.size) continue;
+
+        allocation.memory = block.memory;
+        allocation.offset = alignedOffset;
+        allocation.size = requirements.size;
+        allocation.mapped = block.mapped ? block.mapped + alignedOffset : nullptr;
+        allocation.blockIndex = blockIndex;
+        allocation.rangeOffset = range.offset;
+        allocation.rangeSize = padding + requirements.size;
+
+        block.used += requirements.size;
+        block.wasted += padding;
+        block.allocationCount++;
+
+        range.offset += allocation.rangeSize;
+        range.size -= allocation.rangeSize;
+        if (range.size == 0) block.freeRanges.erase(block.freeRanges.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements &requirements,
+                                           VkMemoryPropertyFlags properties, bool linear) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+    bool hostVisible = memoryProperties_.memoryTypes[memoryTypeIndex].propertyFlags &
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    VkDeviceSize blockSize = hostVisible ? hostVisibleBlockSize_ : deviceLocalBlockSize_;
+
+    MemoryAllocation allocation;
+    if (requirements.size > blockSize / 2) {
+        // big stuff (render targets, the upload ring) would just fragment the blocks
+        uint32_t blockIndex = createBlock(memoryTypeIndex, requirements.size, linear, true);
+        allocateFromBlock(blockIndex, requirements, allocation);
+        return allocation;
+    }
+
+    for (uint32_t i = 0; i < blocks_.size(); ++i) {
+        const auto &block = blocks_[i];
+        if (!block || block->dedicated || block->memoryTypeIndex != memoryTypeIndex ||
+            block->linear != linear) {
+            continue;
+        }
+        if (allocateFromBlock(i, requirements, allocation)) return allocation;
+    }
+
+    uint32_t blockIndex = createBlock(memoryTypeIndex, blockSize, linear, false);
+    allocateFromBlock(blockIndex, requirements, allocation);
+    return allocation;
+}
+
+void MemoryAllocator::free(MemoryAllocation &allocation) {
+    if (!allocation.valid()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Block &block = *blocks_[allocation.blockIndex];
+    block.used -= allocation.size;
+    block.wasted -= allocation.rangeSize - allocation.size;
+    block.allocationCount--;
+
+    if (block.dedicated) {
+        if (block.mapped) vkUnmapMemory(device_, block.memory);
+        vkFreeMemory(device_, block.memory, nullptr);
+        liveDeviceAllocations_--;
+        blocks_[allocation.blockIndex].reset();
+        allocation = {};
+        return;
+    }
+
+    // put the range back in order and merge with whatever it touches
+    auto &ranges = block.freeRanges;
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), allocation.rangeOffset,
+                               [](const Range &r, VkDeviceSize offset) {
+                                   return r.offset < offset;
+                               });
+    it = ranges.insert(it, {allocation.rangeOffset, allocation.rangeSize});
+    if (it + 1 != ranges.end() && it->offset + it->size == (it + 1)->offset) {
+        it->size += (it + 1)->size;
+        ranges.erase(it + 1);
+    }
+    if (it != ranges.begin() && (it - 1)->offset + (it - 1)->size == it->offset) {
+        (it - 1)->size += it->size;
+        ranges.erase(it);
+    }
+    // empty blocks are kept around, the game reallocates the same sizes on restart anyway
+    allocation = {};
+}
+
+MemoryAllocator::Stats MemoryAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    for (const auto &block: blocks_) {
+        if (!block) continue;
+        stats.bytesReserved += block->size;
+        stats.bytesUsed += block->used;
+        stats.bytesWasted += block->wasted;
+        stats.allocationCount += block->allocationCount;
+        if (block->dedicated)
+            stats.dedicatedCount++;
+        else
+            stats.blockCount++;
+    }
+    return stats;
+}
+
+void MemoryAllocator::logStats() const {
+    Stats stats = getStats();
+    LOGE("Device memory: %u allocations in %u blocks + %u dedicated, %.2f MB reserved, "
+         "%.2f MB used, %llu bytes wasted to alignment",
+         stats.allocationCount, stats.blockCount, stats.dedicatedCount,
+         stats.bytesReserved / (1024.0 * 1024.0), stats.bytesUsed / (1024.0 * 1024.0),
+         (unsigned long long) stats.bytesWasted);
+}
@@ -0,0 +1,98 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_MEMORYALLOCATOR_H
+#define SPACEINVADERS3D_MEMORYALLOCATOR_H
+
+#include "GameObjectData.h"
+#include <memory>
+#include <mutex>
+
+// A piece of a bigger VkDeviceMemory block (or a dedicated one for big resources).
+// Host visible memory is mapped once per block, so use `mapped` instead of vkMapMemory.
+struct MemoryAllocation {
+    VkDeviceMemory memory{VK_NULL_HANDLE};
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+    void *mapped{nullptr};
+
+    // bookkeeping for free(), the range actually taken out of the block incl. alignment padding
+    uint32_t blockIndex{UINT32_MAX};
+    VkDeviceSize rangeOffset{0};
+    VkDeviceSize rangeSize{0};
+
+    bool valid() const { return memory != VK_NULL_HANDLE; }
+};
+
+// Block based sub-allocator so every little vertex/index buffer doesn't cost a vkAllocateMemory.
+// Blocks are pooled per memory type, and buffers (linear) and images (optimal tiling) never share
+// a block so bufferImageGranularity can be ignored. Anything bigger than half a block gets its own
+// dedicated allocation.
+class MemoryAllocator {
+public:
+    struct Stats {
+        VkDeviceSize bytesReserved = 0; // total vkAllocateMemory'd, blocks + dedicated
+        VkDeviceSize bytesUsed = 0;     // handed out to resources
+        VkDeviceSize bytesWasted = 0;   // alignment padding in front of live allocations
+        uint32_t blockCount = 0;
+        uint32_t dedicatedCount = 0;
+        uint32_t allocationCount = 0;
+    };
+
+    MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice,
+                    VkDeviceSize deviceLocalBlockSize = 16 * 1024 * 1024,
+                    VkDeviceSize hostVisibleBlockSize = 4 * 1024 * 1024);
+
+    ~MemoryAllocator();
+
+    MemoryAllocation allocate(const VkMemoryRequirements &requirements,
+                              VkMemoryPropertyFlags properties, bool linear);
+
+    void free(MemoryAllocation &allocation);
+
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+
+    Stats getStats() const;
+
+    void logStats() const;
+
+private:
+    struct Range {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    struct Block {
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize size{0};
+        uint8_t *mapped{nullptr};
+        uint32_t memoryTypeIndex{0};
+        bool linear{true};
+        bool dedicated{false};
+        std::vector<Range> freeRanges; // sorted by offset, neighbours always merged
+        VkDeviceSize used{0};
+        VkDeviceSize wasted{0};
+        uint32_t allocationCount{0};
+    };
+
+    VkDevice device_{VK_NULL_HANDLE};
+    VkPhysicalDeviceMemoryProperties memoryProperties_{};
+    uint32_t maxAllocationCount_{0};
+    VkDeviceSize deviceLocalBlockSize_;
+    VkDeviceSize hostVisibleBlockSize_;
+
+    // indices are stable (handed out in MemoryAllocation), released blocks leave a hole
+    std::vector<std::unique_ptr<Block>> blocks_;
+    uint32_t liveDeviceAllocations_{0};
+    mutable std::mutex mutex_;
+
+    uint32_t createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool linear,
+                         bool dedicated);
+
+    bool allocateFromBlock(uint32_t blockIndex, const VkMemoryRequirements &requirements,
+                           MemoryAllocation &allocation);
+};
+
+
+#endif //SPACEINVADERS3D_MEMORYALLOCATOR_H
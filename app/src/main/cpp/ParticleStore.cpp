@@ -0,0 +1,207 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "ParticleStore.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+ParticleStore::ParticleStore(uint32_t capacity, OverflowPolicy overflowPolicy)
+        : capacity_(capacity),
+          overflowPolicy_(overflowPolicy),
+          posX_(capacity), posY_(capacity),
+          velX_(capacity), velY_(capacity),
+          accX_(capacity), accY_(capacity),
+          life_(capacity), maxLife_(capacity),
+          appearance_(capacity) {
+}
+
+bool ParticleStore::spawn(const glm::vec2 &position, const glm::vec2 &velocity, float life,
+                          float size, const glm::vec4 &color) {
+    if (count_ == capacity_) {
+        switch (overflowPolicy_) {
+            case OverflowPolicy::DropNew:
+                stats_.dropped++;
+                return false;
+            case OverflowPolicy::KillOldest:
+                if (capacity_ == 0) return false;
+                head_ = slot(1);
+                count_--;
+                stats_.killed++;
+                break;
+            case OverflowPolicy::Grow:
+                grow();
+                break;
+        }
+    }
+    uint32_t index = slot(count_++);
+    posX_[index] = position.x;
+    posY_[index] = position.y;
+    velX_[index] = velocity.x;
+    velY_[index] = velocity.y;
+    accX_[index] = 0.0f;
+    accY_[index] = 0.0f;
+    life_[index] = maxLife_[index] = life;
+    appearance_[index] = {size, 0.0f, color};
+    stats_.spawned++;
+    stats_.peakLive = std::max(stats_.peakLive, count_);
+    return true;
+}
+
+template<typename Fn>
+void ParticleStore::forEachSpan(Fn &&fn) const {
+    uint32_t firstRun = std::min(count_, capacity_ - head_);
+    if (firstRun > 0) fn(head_, head_ + firstRun, 0u);
+    if (count_ > firstRun) fn(0u, count_ - firstRun, firstRun);
+}
+
+template<typename Fn>
+void ParticleStore::parallelFor(uint32_t begin, uint32_t end, Fn &&fn) const {
+    if (!jobs_ || end - begin < PARALLEL_THRESHOLD) {
+        fn(begin, end);
+        return;
+    }
+    // chunks stay multiples of 4 so only the last one has a scalar tail
+    jobs_->parallelFor(begin, end, PARALLEL_GRAIN, fn);
+}
+
+void ParticleStore::grow() {
+    uint32_t capacity = std::max(16u, capacity_ * 2);
+    // unrolls the ring while copying, head ends up at 0
+    auto regrow = [this, capacity](auto &field) {
+        std::remove_reference_t<decltype(field)> grown(capacity);
+        forEachSpan([&](uint32_t begin, uint32_t end, uint32_t index) {
+            std::copy(field.begin() + begin, field.begin() + end, grown.begin() + index);
+        });
+        field.swap(grown);
+    };
+    regrow(posX_);
+    regrow(posY_);
+    regrow(velX_);
+    regrow(velY_);
+    regrow(accX_);
+    regrow(accY_);
+    regrow(life_);
+    regrow(maxLife_);
+    regrow(appearance_);
+    capacity_ = capacity;
+    head_ = 0;
+}
+
+void ParticleStore::integrateRange(uint32_t begin, uint32_t end, float deltaTime) {
+    float *posX = posX_.data(), *posY = posY_.data();
+    float *velX = velX_.data(), *velY = velY_.data();
+    const float *accX = accX_.data(), *accY = accY_.data();
+    float *life = life_.data();
+    uint32_t i = begin;
+
+#if defined(__ARM_NEON)
+    float32x4_t dt = vdupq_n_f32(deltaTime);
+    for (; i + 4 <= end; i += 4) {
+        float32x4_t vx = vmlaq_f32(vld1q_f32(velX + i), vld1q_f32(accX + i), dt);
+        float32x4_t vy = vmlaq_f32(vld1q_f32(velY + i), vld1q_f32(accY + i), dt);
+        vst1q_f32(velX + i, vx);
+        vst1q_f32(velY + i, vy);
+        vst1q_f32(posX + i, vmlaq_f32(vld1q_f32(posX + i), vx, dt));
+        vst1q_f32(posY + i, vmlaq_f32(vld1q_f32(posY + i), vy, dt));
+        vst1q_f32(life + i, vsubq_f32(vld1q_f32(life + i), dt));
+    }
+#elif defined(__SSE2__)
+    __m128 dt = _mm_set1_ps(deltaTime);
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(velX + i), _mm_mul_ps(_mm_loadu_ps(accX + i), dt));
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(velY + i), _mm_mul_ps(_mm_loadu_ps(accY + i), dt));
+        _mm_storeu_ps(velX + i, vx);
+        _mm_storeu_ps(velY + i, vy);
+        _mm_storeu_ps(posX + i, _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(posY + i, _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), dt));
+    }
+#endif
+    for (; i < end; ++i) {
+        velX[i] += accX[i] * deltaTime;
+        velY[i] += accY[i] * deltaTime;
+        posX[i] += velX[i] * deltaTime;
+        posY[i] += velY[i] * deltaTime;
+        life[i] -= deltaTime;
+    }
+}
+
+void ParticleStore::moveRun(uint32_t from, uint32_t to, uint32_t count) {
+    // to is never ahead of from, so copying front to back is safe even when they overlap
+    while (count > 0) {
+        uint32_t n = std::min({count, capacity_ - from, capacity_ - to});
+        auto move = [from, to, n](auto &field) {
+            std::copy(field.begin() + from, field.begin() + from + n, field.begin() + to);
+        };
+        move(posX_);
+        move(posY_);
+        move(velX_);
+        move(velY_);
+        move(accX_);
+        move(accY_);
+        move(life_);
+        move(maxLife_);
+        move(appearance_);
+        from = from + n == capacity_ ? 0 : from + n;
+        to = to + n == capacity_ ? 0 : to + n;
+        count -= n;
+    }
+}
+
+void ParticleStore::removeDead() {
+    // the oldest die first most of the time, those just move the head
+    while (count_ > 0 && life_[head_] <= 0.0f) {
+        head_ = slot(1);
+        count_--;
+    }
+
+    // stable from the first hole on so the ring stays in spawn order, runs of survivors
+    // are moved in one go
+    uint32_t kept = 0;
+    uint32_t i = 0;
+    while (i < count_) {
+        uint32_t runStart = i;
+        while (i < count_ && life_[slot(i)] > 0.0f) i++;
+        if (kept != runStart) moveRun(slot(runStart), slot(kept), i - runStart);
+        kept += i - runStart;
+        while (i < count_ && life_[slot(i)] <= 0.0f) i++;
+    }
+    count_ = kept;
+}
+
+void ParticleStore::update(float deltaTime) {
+    forEachSpan([this, deltaTime](uint32_t begin, uint32_t end, uint32_t) {
+        parallelFor(begin, end, [this, deltaTime](uint32_t first, uint32_t last) {
+            integrateRange(first, last, deltaTime);
+        });
+    });
+    removeDead();
+}
+
+void ParticleStore::writeRange(ParticleInstance *out, uint32_t begin, uint32_t end) const {
+    for (uint32_t i = begin; i < end; ++i) {
+        const Appearance &look = appearance_[i];
+        ParticleInstance &instance = out[i - begin];
+        instance.center = {posX_[i], posY_[i]};
+        instance.size = look.size;
+        instance.rotation = look.rotation;
+        instance.color = look.color;
+        instance.color.a *= std::clamp(life_[i] / maxLife_[i], 0.0f, 1.0f); // fade out
+    }
+}
+
+void ParticleStore::writeInstances(ParticleInstance *out) const {
+    forEachSpan([this, out](uint32_t begin, uint32_t end, uint32_t index) {
+        parallelFor(begin, end, [this, out, begin, index](uint32_t first, uint32_t last) {
+            writeRange(out + index + (first - begin), first, last);
+        });
+    });
+}
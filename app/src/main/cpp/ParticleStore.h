@@ -0,0 +1,146 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_PARTICLESTORE_H
+#define SPACEINVADERS3D_PARTICLESTORE_H
+
+#include "GameObjectData.h"
+#include <vector>
+
+class JobSystem;
+
+// What particles_instanced.vert reads per particle, nothing else goes to the GPU
+struct ParticleInstance {
+    glm::vec2 center;   // Center in NDC
+    float size;         // Size in NDC (or world units if transforming)
+    float rotation;     // Radians, only used if the shader's rotation path is switched on
+    glm::vec4 color;    // RGBA
+
+    // Vertex input: just position
+    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions() {
+        std::vector<VkVertexInputBindingDescription> bindings = {
+                {0, sizeof(Vertex),           VK_VERTEX_INPUT_RATE_VERTEX},
+                {1, sizeof(ParticleInstance), VK_VERTEX_INPUT_RATE_INSTANCE}
+        };
+
+        return bindings;
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributes = {
+                // Quad position (location=0)
+                {0, 0, VK_FORMAT_R32G32B32_SFLOAT,    offsetof(Vertex, pos)},
+                // Instance data (location=1,2,3)
+                {1, 1, VK_FORMAT_R32G32_SFLOAT,       offsetof(ParticleInstance, center)},
+                {2, 1, VK_FORMAT_R32_SFLOAT,          offsetof(ParticleInstance, size)},
+                {3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ParticleInstance, color)}
+        };
+        return attributes;
+    }
+};
+
+static_assert(sizeof(ParticleInstance) == 32, "ParticleInstance is meant to stay 32 bytes");
+
+// What spawn() does once every slot holds a live particle
+enum class OverflowPolicy {
+    DropNew,    // the new particle is thrown away
+    KillOldest, // the oldest live particle makes room
+    Grow        // capacity doubles
+};
+
+// CPU particle simulation state as structure of arrays. Live particles are packed into a ring
+// [head, head + count) in spawn order, so the update loops never branch on an active flag and
+// run 4 wide (NEON/SSE) over at most two spans. Spawning appends at the tail and killing the
+// oldest just advances the head, dead ones are squeezed out once per update keeping the order.
+// Big counts are split across threads.
+class ParticleStore {
+public:
+    // below this a frame's update isn't worth waking other threads for
+    static constexpr uint32_t PARALLEL_THRESHOLD = 16 * 1024;
+    // smallest piece handed to another thread, a multiple of the 4 wide SIMD loops
+    static constexpr uint32_t PARALLEL_GRAIN = 1024;
+
+    struct Stats {
+        uint64_t spawned = 0;
+        uint64_t dropped = 0; // DropNew only
+        uint64_t killed = 0;  // KillOldest only, alive particles that made room
+        uint32_t peakLive = 0;
+    };
+
+    explicit ParticleStore(uint32_t capacity,
+                           OverflowPolicy overflowPolicy = OverflowPolicy::KillOldest);
+
+    // returns false if the particle was dropped
+    bool spawn(const glm::vec2 &position, const glm::vec2 &velocity, float life, float size,
+               const glm::vec4 &color);
+
+    // integrate and age everything, particles that ran out of life are removed
+    void update(float deltaTime);
+
+    // count() instances oldest first, alpha fades with the remaining life
+    void writeInstances(ParticleInstance *out) const;
+
+    void clear() { head_ = count_ = 0; }
+
+    uint32_t count() const { return count_; }
+
+    uint32_t capacity() const { return capacity_; }
+
+    const Stats &stats() const { return stats_; }
+
+    OverflowPolicy overflowPolicy() const { return overflowPolicy_; }
+
+    void setOverflowPolicy(OverflowPolicy overflowPolicy) { overflowPolicy_ = overflowPolicy; }
+
+    // big updates get split over its threads, null = always single threaded
+    void setJobSystem(JobSystem *jobs) { jobs_ = jobs; }
+
+private:
+    // only read by writeInstances, kept out of the arrays the integrate loop streams through
+    struct Appearance {
+        float size;
+        float rotation;
+        glm::vec4 color;
+    };
+
+    uint32_t capacity_ = 0;
+    uint32_t head_ = 0;
+    uint32_t count_ = 0;
+    JobSystem *jobs_ = nullptr;
+    OverflowPolicy overflowPolicy_;
+    Stats stats_;
+
+    std::vector<float> posX_, posY_;
+    std::vector<float> velX_, velY_;
+    std::vector<float> accX_, accY_;
+    std::vector<float> life_, maxLife_;
+    std::vector<Appearance> appearance_;
+
+    void integrateRange(uint32_t begin, uint32_t end, float deltaTime);
+
+    void writeRange(ParticleInstance *out, uint32_t begin, uint32_t end) const;
+
+    // ring position of the index-th oldest live particle
+    uint32_t slot(uint32_t index) const {
+        uint32_t s = head_ + index;
+        return s >= capacity_ ? s - capacity_ : s;
+    }
+
+    void grow();
+
+    void removeDead();
+
+    // count particles starting at ring slot from, to the slots starting at to
+    void moveRun(uint32_t from, uint32_t to, uint32_t count);
+
+    // fn(firstSlot, endSlot, firstIndex) for each contiguous run of the live ring
+    template<typename Fn>
+    void forEachSpan(Fn &&fn) const;
+
+    template<typename Fn>
+    void parallelFor(uint32_t begin, uint32_t end, Fn &&fn) const;
+};
+
+
+#endif //SPACEINVADERS3D_PARTICLESTORE_H
@@ -8,6 +8,10 @@
 #include "Time.h"
 #include "GameObjectData.h"
 #include "PowerUpManager.h"
+#include "UploadRing.h"
+#include "MemoryAllocator.h"
+#include "GpuParticles.h"
+#include "ParticleStore.h"
 
 
 struct ShieldInstance {
@@ -71,53 +75,46 @@ struct StarInstance {
 };
 
 
-struct ParticleInstance {
-    glm::vec3 position;
-    glm::vec3 velocity;
-    glm::vec3 acceleration;
-    float life;
-    float maxLife;
-    bool active;
-    glm::vec3 center;   // Center in NDC
-    float size;         // Size in NDC (or world units if transforming)
-    float rotation;     // Radians
-    glm::vec4 color;    // RGBA
-
-    // Vertex input: just position
-   static std::vector<VkVertexInputBindingDescription> getBindingDescriptions() {
-        std::vector<VkVertexInputBindingDescription> bindings = {
-                {0, sizeof(Vertex),           VK_VERTEX_INPUT_RATE_VERTEX},
-                {1, sizeof(ParticleInstance), VK_VERTEX_INPUT_RATE_INSTANCE}
-        };
-
-        return bindings;
-    }
+// push constants of stars_procedural.vert, the whole star field is derived from these
+struct StarFieldPushConstants {
+    float time;
+    uint32_t seed;
+    uint32_t starsPerLayer;
+    uint32_t layerCount;
+};
 
-   static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
-       std::vector<VkVertexInputAttributeDescription> attributes = {
-               // Quad position (location=0)
-               {0, 0, VK_FORMAT_R32G32B32_SFLOAT,    offsetof(Vertex, pos)},
-               // Instance data (location=1,2,3,4)
-               {1, 1, VK_FORMAT_R32G32_SFLOAT,       offsetof(ParticleInstance, center)},
-               {2, 1, VK_FORMAT_R32_SFLOAT,          offsetof(ParticleInstance, size)},
-               {3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ParticleInstance, color)}
-       };
-       return attributes;
-   }
 
+// an explosion queued for GpuParticles::emit(), which has to happen where the frame is recorded
+struct ParticleEmit {
+    glm::vec3 position;
+    uint32_t count;
 };
 
 
 constexpr int MAX_PARTICLES = 512;
 constexpr int NUM_STARS = 256;
+constexpr uint32_t STAR_FIELD_LAYERS = 3;
+constexpr uint32_t STAR_FIELD_STARS_PER_LAYER = 8192;
+// has to match PERIOD in stars_procedural.vert
+constexpr float STAR_FIELD_PERIOD = 440.0f;
 class ParticleSystem {
 
 private:
 
 
-    int firstFree = 0;
-    std::vector<ParticleInstance> liveParticles;
+    // explosions on the CPU path, drawn count is what the last update uploaded. A full pool
+    // makes room by killing the oldest particles, those have mostly faded out already
+    ParticleStore explosions{MAX_PARTICLES, OverflowPolicy::KillOldest};
+    std::vector<ParticleEmit> gpuEmits;
     std::vector<StarInstance> starInstances;
+    // its own stream so the star field (updated per frame) never shifts gameplay's, seeded from
+    // Util's generator when the system is made
+    std::mt19937 starRng;
+    // same for the CPU explosion spawns: the GPU path draws nothing from Util, so this one can't
+    // either or a replay recorded on one path diverges on the other
+    std::mt19937 explosionRng;
+    StarFieldPushConstants starField{0.0f, 0x5eed5eedu, STAR_FIELD_STARS_PER_LAYER,
+                                     STAR_FIELD_LAYERS};
 
 
     void initStarField();
@@ -125,12 +122,17 @@ private:
 public:
     VkDevice device;
     std::shared_ptr<PowerUpManager> powerUpManager;
+    // set = explosions are simulated on the GPU, spawn() just queues emits for takeGpuEmits()
+    GpuParticles *gpuParticles = nullptr;
+    // set = stars are computed in stars_procedural.vert, updateStarField() only advances time
+    bool proceduralStars = false;
+
+    // lets big explosion updates split up over the job system's threads
+    void setJobSystem(JobSystem *jobs) { explosions.setJobSystem(jobs); }
     VkBuffer haloVertexBuffer{VK_NULL_HANDLE};
     VkBuffer haloIndexBuffer{VK_NULL_HANDLE};
-    VkBuffer haloInstanceBuffer{VK_NULL_HANDLE};
-    VkDeviceMemory haloInstanceBufferMemory{VK_NULL_HANDLE};
-    VkDeviceMemory haloVertexBufferMemory{VK_NULL_HANDLE};
-    VkDeviceMemory haloIndexBufferMemory{VK_NULL_HANDLE};
+    MemoryAllocation haloVertexBufferMemory;
+    MemoryAllocation haloIndexBufferMemory;
 
 
     ParticleSystem();
@@ -139,28 +141,45 @@ public:
 
     ~ParticleSystem();
 
-    ParticleInstance particles[MAX_PARTICLES];
+    void spawn(const glm::vec3 &pos, int count);
+
+    // The update*() calls run on the game thread and only fill in CPU side copies, the record*()
+    // calls only use what they're given, so the two can run on different threads
 
+    // update + copy this frame's instances out
+    void updateExplosionParticles(std::vector<ParticleInstance> &instances);
 
-    void spawn(const glm::vec3 &pos, int count);
+    // stars is left empty in procedural mode, pushConstants is what to draw them with then
+    void updateStarField(std::vector<StarInstance> &stars, StarFieldPushConstants &pushConstants);
 
-    void updateExplosionParticles(VkDeviceMemory particlesInstanceBufferMemory);
-    void updateStarField(VkDeviceMemory starInstanceBufferMemory);
+    // moves the emits queued since the last call into emits
+    void takeGpuEmits(std::vector<ParticleEmit> &emits);
 
+    // instanceCount quads, skipped if nothing was uploaded (or the ring was full)
     void recordCommandBuffer(VkCommandBuffer cmd,
-                             VkPipelineLayout pipelineLayout,
                              VkPipeline pipeline,
                              VkBuffer vertexBuffer,
                              VkBuffer indexBuffer,
-                             VkBuffer instanceBuffer,
-                             GfxPipelineType gfxPipelineType);
+                             const UploadRing::Allocation &instances,
+                             uint32_t instanceCount);
+
+    // draws the procedural star field, pipelineLayout needs the StarFieldPushConstants range
+    void recordStarField(VkCommandBuffer cmd,
+                         VkPipelineLayout pipelineLayout,
+                         VkPipeline pipeline,
+                         VkBuffer vertexBuffer,
+                         VkBuffer indexBuffer,
+                         const StarFieldPushConstants &pushConstants);
 
     void initExplosionParticles();
 
+    const ParticleStore::Stats &explosionStats() const { return explosions.stats(); }
+
 
     VkPipeline haloPipeline;
 
-    void updateHaloEffect(Ship ship);
+    // false while the shield is off, nothing to draw then
+    bool updateHaloEffect(glm::vec2 shipPos, float shipSize, ShieldInstance &halo);
 };
 
 
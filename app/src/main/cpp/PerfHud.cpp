@@ -0,0 +1,163 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "PerfHud.h"
+#include <algorithm>
+#include <cstdio>
+
+static const char *CPU_PHASE_NAMES[] = {"aliens", "collision", "explosions", "stars", "score",
+                                        "record"};
+static const char *GPU_PASS_NAMES[] = {"stars", "sprites", "text", "particles", "halo"};
+
+void RollingStats::add(float value) {
+    samples_[next_] = value;
+    next_ = (next_ + 1) % WINDOW;
+    count_ = std::min(count_ + 1, WINDOW);
+}
+
+RollingStats::Summary RollingStats::summary() const {
+    Summary result;
+    if (count_ == 0) return result;
+    std::array<float, WINDOW> sorted;
+    std::copy(samples_.begin(), samples_.begin() + count_, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + count_);
+
+    float total = 0.0f;
+    for (uint32_t i = 0; i < count_; ++i) total += sorted[i];
+    result.min = sorted[0];
+    result.avg = total / count_;
+    result.p99 = sorted[std::min(count_ - 1, count_ * 99 / 100)];
+    return result;
+}
+
+PerfHud::PerfHud(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily,
+                 uint32_t framesInFlight)
+        : device_(device), framesInFlight_(framesInFlight), slotWritten_(framesInFlight, false) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    uint32_t validBits = families[queueFamily].timestampValidBits;
+    if (validBits == 0 || properties.limits.timestampPeriod == 0.0f) {
+        LOGE("Queue family %u has no timestamps, perf HUD shows CPU times only", queueFamily);
+        return;
+    }
+    timestampPeriodNs_ = properties.limits.timestampPeriod;
+    timestampMask_ = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = QUERIES_PER_FRAME * framesInFlight_;
+    if (vkCreateQueryPool(device_, &poolInfo, nullptr, &queryPool_) != VK_SUCCESS) {
+        LOGE("Failed to create timestamp query pool, perf HUD shows CPU times only");
+        queryPool_ = VK_NULL_HANDLE;
+    }
+}
+
+PerfHud::~PerfHud() {
+    if (queryPool_ != VK_NULL_HANDLE) vkDestroyQueryPool(device_, queryPool_, nullptr);
+}
+
+void PerfHud::beginFrame(VkCommandBuffer cmd, uint32_t frameIndex) {
+    currentFrame_ = frameIndex;
+    if (queryPool_ == VK_NULL_HANDLE) return;
+    if (slotWritten_[frameIndex]) collectResults(frameIndex);
+    vkCmdResetQueryPool(cmd, queryPool_, frameIndex * QUERIES_PER_FRAME, QUERIES_PER_FRAME);
+    slotWritten_[frameIndex] = true;
+}
+
+// on tilers these bracket the commands rather than the tile work, still good enough for trends
+void PerfHud::beginPass(VkCommandBuffer cmd, GpuPass pass) {
+    if (queryPool_ == VK_NULL_HANDLE) return;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool_,
+                        currentFrame_ * QUERIES_PER_FRAME + static_cast<uint32_t>(pass) * 2);
+}
+
+void PerfHud::endPass(VkCommandBuffer cmd, GpuPass pass) {
+    if (queryPool_ == VK_NULL_HANDLE) return;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool_,
+                        currentFrame_ * QUERIES_PER_FRAME + static_cast<uint32_t>(pass) * 2 + 1);
+}
+
+void PerfHud::collectResults(uint32_t frameIndex) {
+    // no WAIT bit: the fence already covers these, anything not ready is just skipped
+    uint64_t results[QUERIES_PER_FRAME * 2];
+    VkResult res = vkGetQueryPoolResults(device_, queryPool_, frameIndex * QUERIES_PER_FRAME,
+                                         QUERIES_PER_FRAME, sizeof(results), results,
+                                         sizeof(uint64_t) * 2,
+                                         VK_QUERY_RESULT_64_BIT |
+                                         VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (res != VK_SUCCESS && res != VK_NOT_READY) return;
+
+    for (uint32_t pass = 0; pass < static_cast<uint32_t>(GpuPass::Count); ++pass) {
+        const uint64_t *begin = &results[pass * 4];
+        const uint64_t *end = &results[pass * 4 + 2];
+        if (!begin[1] || !end[1]) continue;
+        uint64_t ticks = ((end[0] & timestampMask_) - (begin[0] & timestampMask_)) &
+                         timestampMask_;
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        gpuStats_[pass].add(static_cast<float>(ticks * timestampPeriodNs_ / 1e6));
+    }
+}
+
+UploadRing::Allocation PerfHud::uploadText(FontManager &fontManager, UploadRing &ring) {
+    // building glyph quads isn't free and nobody can read numbers changing at 60 Hz anyway
+    if (++framesSinceText_ >= TEXT_REFRESH_FRAMES) {
+        framesSinceText_ = 0;
+        textVertices_.clear();
+
+        const float scale = 0.0018f, lineHeight = 0.055f;
+        float y = -0.7f;
+        auto addLine = [&](const char *text) {
+            auto vertices = fontManager.buildTextVertices(text, -0.95f, y, 0.0f, scale);
+            textVertices_.insert(textVertices_.end(), vertices.begin(), vertices.end());
+            y += lineHeight;
+        };
+        auto addStats = [&](const char *label, const RollingStats &stats) {
+            RollingStats::Summary s = stats.summary();
+            char line[64];
+            snprintf(line, sizeof(line), "%-10s %5.2f %5.2f %5.2f", label, s.min, s.avg, s.p99);
+            addLine(line);
+        };
+
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        addLine("ms         min   avg   p99");
+        addStats("frame", frameStats_);
+        for (size_t i = 0; i < cpuStats_.size(); ++i) addStats(CPU_PHASE_NAMES[i], cpuStats_[i]);
+        if (gpuTimingSupported()) {
+            addLine("gpu");
+            for (size_t i = 0; i < gpuStats_.size(); ++i) {
+                addStats(GPU_PASS_NAMES[i], gpuStats_[i]);
+            }
+        }
+    }
+    if (textVertices_.empty()) return {};
+    return ring.push(textVertices_.data(), textVertices_.size() * sizeof(Vertex));
+}
+
+std::string PerfHud::summary() const {
+    std::string out;
+    char line[96];
+    auto addStats = [&](const char *kind, const char *label, const RollingStats &stats) {
+        RollingStats::Summary s = stats.summary();
+        snprintf(line, sizeof(line), "%s %-10s min %6.3f avg %6.3f p99 %6.3f ms\n", kind, label,
+                 s.min, s.avg, s.p99);
+        out += line;
+    };
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    addStats("cpu", "frame", frameStats_);
+    for (size_t i = 0; i < cpuStats_.size(); ++i) {
+        addStats("cpu", CPU_PHASE_NAMES[i], cpuStats_[i]);
+    }
+    if (gpuTimingSupported()) {
+        for (size_t i = 0; i < gpuStats_.size(); ++i) {
+            addStats("gpu", GPU_PASS_NAMES[i], gpuStats_[i]);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,139 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_PERFHUD_H
+#define SPACEINVADERS3D_PERFHUD_H
+
+#include "GameObjectData.h"
+#include "FontManager.h"
+#include "UploadRing.h"
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+
+enum class CpuPhase {
+    UpdateAliens,
+    UpdateCollision,
+    UpdateExplosionParticles,
+    UpdateStarField,
+    AnimateScore,
+    RecordCommandBuffer,
+    Count
+};
+
+enum class GpuPass {
+    Stars,
+    Sprites,
+    Text,
+    Particles,
+    Halo,
+    Count
+};
+
+// Fixed window of the most recent samples, min/avg/p99 are worked out on demand
+class RollingStats {
+public:
+    static constexpr uint32_t WINDOW = 240; // ~4 s at 60 fps
+
+    struct Summary {
+        float min = 0.0f;
+        float avg = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    void add(float value);
+
+    Summary summary() const;
+
+private:
+    std::array<float, WINDOW> samples_{};
+    uint32_t next_ = 0;
+    uint32_t count_ = 0;
+};
+
+// Frame time, CPU phase times and GPU pass times (timestamp queries), drawn as text through the
+// font pipeline. GPU results are read back for a frame slot only after its fence was waited on,
+// so they never stall and show up framesInFlight frames late.
+// The stats can be added to from the game and render threads, the Vulkan side is render thread only.
+class PerfHud {
+public:
+    // times a CPU phase for as long as it's in scope, hud may be null (HUD off)
+    class CpuScope {
+    public:
+        CpuScope(PerfHud *hud, CpuPhase phase) : hud_(hud), phase_(phase) {
+            if (hud_) start_ = std::chrono::steady_clock::now();
+        }
+
+        ~CpuScope() {
+            if (hud_) {
+                hud_->addCpuTime(phase_, std::chrono::duration<float, std::milli>(
+                        std::chrono::steady_clock::now() - start_).count());
+            }
+        }
+
+    private:
+        PerfHud *hud_;
+        CpuPhase phase_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    PerfHud(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily,
+            uint32_t framesInFlight);
+
+    ~PerfHud();
+
+    void addFrameTime(float ms) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        frameStats_.add(ms);
+    }
+
+    void addCpuTime(CpuPhase phase, float ms) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        cpuStats_[static_cast<size_t>(phase)].add(ms);
+    }
+
+    // Call after the frame slot's fence was waited on and outside a render pass: collects the
+    // slot's previous results and resets its queries
+    void beginFrame(VkCommandBuffer cmd, uint32_t frameIndex);
+
+    void beginPass(VkCommandBuffer cmd, GpuPass pass);
+
+    void endPass(VkCommandBuffer cmd, GpuPass pass);
+
+    // rebuilds the text every few frames and pushes it into this frame's slice of the ring
+    UploadRing::Allocation uploadText(FontManager &fontManager, UploadRing &ring);
+
+    uint32_t textVertexCount() const { return static_cast<uint32_t>(textVertices_.size()); }
+
+    // same numbers as the overlay, one line per stat
+    std::string summary() const;
+
+    bool gpuTimingSupported() const { return queryPool_ != VK_NULL_HANDLE; }
+
+private:
+    static constexpr uint32_t QUERIES_PER_FRAME = static_cast<uint32_t>(GpuPass::Count) * 2;
+    static constexpr uint32_t TEXT_REFRESH_FRAMES = 30;
+
+    VkDevice device_{VK_NULL_HANDLE};
+    VkQueryPool queryPool_{VK_NULL_HANDLE};
+    float timestampPeriodNs_ = 1.0f;
+    uint64_t timestampMask_ = ~0ull;
+    uint32_t framesInFlight_ = 0;
+    uint32_t currentFrame_ = 0;
+    std::vector<bool> slotWritten_; // per frame slot, nothing to read back before the first use
+
+    mutable std::mutex statsMutex_; // guards the RollingStats
+    RollingStats frameStats_;
+    std::array<RollingStats, static_cast<size_t>(CpuPhase::Count)> cpuStats_;
+    std::array<RollingStats, static_cast<size_t>(GpuPass::Count)> gpuStats_;
+
+    std::vector<Vertex> textVertices_;
+    uint32_t framesSinceText_ = TEXT_REFRESH_FRAMES;
+
+    void collectResults(uint32_t frameIndex);
+};
+
+
+#endif //SPACEINVADERS3D_PERFHUD_H
@@ -0,0 +1,348 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "PipelineRegistry.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+static const uint32_t CACHE_FILE_MAGIC = 0x43505653; // "SVPC"
+static const uint32_t CACHE_FILE_VERSION = 1;
+
+uint64_t PipelineRegistry::hashBytes(const void *data, size_t size, uint64_t seed) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template<typename T>
+static void hashValue(uint64_t &hash, const T &value) {
+    hash = PipelineRegistry::hashBytes(&value, sizeof(T), hash);
+}
+
+uint64_t PipelineRegistry::hashState(const VkGraphicsPipelineCreateInfo &info,
+                                     uint64_t shaderHash) {
+    // only the state this renderer actually sets, field by field so struct padding stays out
+    uint64_t hash = hashBytes(&shaderHash, sizeof(shaderHash));
+    for (uint32_t i = 0; i < info.stageCount; ++i) {
+        hashValue(hash, info.pStages[i].stage);
+        hash = hashBytes(info.pStages[i].pName, strlen(info.pStages[i].pName), hash);
+    }
+
+    if (const auto *vertexInput = info.pVertexInputState) {
+        // binding/attribute descriptions are all uint32 fields, no padding
+        hash = hashBytes(vertexInput->pVertexBindingDescriptions,
+                         vertexInput->vertexBindingDescriptionCount *
+                         sizeof(VkVertexInputBindingDescription), hash);
+        hash = hashBytes(vertexInput->pVertexAttributeDescriptions,
+                         vertexInput->vertexAttributeDescriptionCount *
+                         sizeof(VkVertexInputAttributeDescription), hash);
+    }
+    if (const auto *inputAssembly = info.pInputAssemblyState) {
+        hashValue(hash, inputAssembly->topology);
+        hashValue(hash, inputAssembly->primitiveRestartEnable);
+    }
+    if (const auto *viewport = info.pViewportState) {
+        hash = hashBytes(viewport->pViewports, viewport->viewportCount * sizeof(VkViewport), hash);
+        hash = hashBytes(viewport->pScissors, viewport->scissorCount * sizeof(VkRect2D), hash);
+    }
+    if (const auto *raster = info.pRasterizationState) {
+        hashValue(hash, raster->depthClampEnable);
+        hashValue(hash, raster->rasterizerDiscardEnable);
+        hashValue(hash, raster->polygonMode);
+        hashValue(hash, raster->cullMode);
+        hashValue(hash, raster->frontFace);
+        hashValue(hash, raster->lineWidth);
+    }
+    if (const auto *multisample = info.pMultisampleState) {
+        hashValue(hash, multisample->rasterizationSamples);
+        hashValue(hash, multisample->sampleShadingEnable);
+    }
+    if (const auto *blend = info.pColorBlendState) {
+        hashValue(hash, blend->logicOpEnable);
+        hashValue(hash, blend->logicOp);
+        hash = hashBytes(blend->pAttachments,
+                         blend->attachmentCount * sizeof(VkPipelineColorBlendAttachmentState),
+                         hash);
+    }
+    hashValue(hash, info.layout);
+    hashValue(hash, info.renderPass);
+    hashValue(hash, info.subpass);
+    return hash;
+}
+
+PipelineRegistry::PipelineRegistry(VkDevice device, VkPhysicalDevice physicalDevice,
+                                   std::string cacheFile)
+        : device_(device), cacheFile_(std::move(cacheFile)) {
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties_);
+
+    std::vector<uint8_t> initialData = loadCacheData();
+    loadedFromDisk_ = !initialData.empty();
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = initialData.size();
+    cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+    if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &cache_) != VK_SUCCESS) {
+        // driver didn't like the blob after all, an empty cache still works
+        LOGE("Pipeline cache rejected, starting empty");
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        loadedFromDisk_ = false;
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &cache_) != VK_SUCCESS) {
+            LOGE("Failed to create pipeline cache");
+            throw std::runtime_error("Failed to create pipeline cache");
+        }
+    }
+    LOGE("Pipeline cache: %s (%zu bytes)", loadedFromDisk_ ? "warm" : "cold",
+         initialData.size());
+}
+
+PipelineRegistry::~PipelineRegistry() {
+    for (auto &worker: workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    for (auto cache: workerCaches_) {
+        vkDestroyPipelineCache(device_, cache, nullptr);
+    }
+    for (auto &job: queue_) {
+        if (job->pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device_, job->pipeline, nullptr);
+    }
+    for (auto &entry: pipelines_) {
+        vkDestroyPipeline(device_, entry.second, nullptr);
+    }
+    vkDestroyPipelineCache(device_, cache_, nullptr);
+}
+
+std::vector<uint8_t> PipelineRegistry::loadCacheData() {
+    if (cacheFile_.empty()) return {};
+    std::ifstream in(cacheFile_, std::ios::binary);
+    if (!in) return {};
+
+    FileHeader header{};
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) return {};
+    if (header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION) {
+        LOGE("Pipeline cache file has the wrong format, ignoring it");
+        return {};
+    }
+    // a driver update or a different GPU makes the old blob useless (or worse)
+    if (header.vendorID != properties_.vendorID || header.deviceID != properties_.deviceID ||
+        header.driverVersion != properties_.driverVersion ||
+        memcmp(header.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        LOGE("Pipeline cache is from another device/driver, ignoring it");
+        return {};
+    }
+
+    std::vector<uint8_t> data(header.dataSize);
+    if (!in.read(reinterpret_cast<char *>(data.data()), data.size()) ||
+        hashBytes(data.data(), data.size()) != header.dataHash) {
+        LOGE("Pipeline cache file is truncated or corrupt, ignoring it");
+        return {};
+    }
+
+    // the driver's own header should agree too, some drivers don't check it themselves
+    VkPipelineCacheHeaderVersionOne vkHeader{};
+    if (data.size() < sizeof(vkHeader)) return {};
+    memcpy(&vkHeader, data.data(), sizeof(vkHeader));
+    if (vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        vkHeader.vendorID != properties_.vendorID || vkHeader.deviceID != properties_.deviceID ||
+        memcmp(vkHeader.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        LOGE("Pipeline cache blob header doesn't match the device, ignoring it");
+        return {};
+    }
+    return data;
+}
+
+bool PipelineRegistry::save() const {
+    if (cacheFile_.empty()) return false;
+
+    size_t size = 0;
+    vkGetPipelineCacheData(device_, cache_, &size, nullptr);
+    std::vector<uint8_t> data(size);
+    if (size == 0 || vkGetPipelineCacheData(device_, cache_, &size, data.data()) != VK_SUCCESS) {
+        LOGE("Couldn't read back pipeline cache data");
+        return false;
+    }
+
+    FileHeader header{};
+    header.magic = CACHE_FILE_MAGIC;
+    header.version = CACHE_FILE_VERSION;
+    header.vendorID = properties_.vendorID;
+    header.deviceID = properties_.deviceID;
+    header.driverVersion = properties_.driverVersion;
+    memcpy(header.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = size;
+    header.dataHash = hashBytes(data.data(), size);
+
+    // write next to it and rename so a kill mid-write can't leave half a file behind
+    std::string tmpFile = cacheFile_ + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(data.data()), size);
+        if (!out.good()) {
+            LOGE("Failed to write pipeline cache to %s", tmpFile.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), cacheFile_.c_str()) != 0) {
+        LOGE("Failed to move pipeline cache to %s", cacheFile_.c_str());
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    LOGE("Pipeline cache saved: %zu bytes, %zu pipelines (%u deduped)", size, pipelines_.size(),
+         dedupedCount_);
+    return true;
+}
+
+uint64_t PipelineRegistry::enqueue(const VkGraphicsPipelineCreateInfo &info,
+                                   uint64_t shaderHash) {
+    uint64_t key = hashState(info, shaderHash);
+    bool queued = std::any_of(queue_.begin(), queue_.end(),
+                              [key](const auto &job) { return job->key == key; });
+    if (queued || pipelines_.count(key)) {
+        dedupedCount_++;
+        return key;
+    }
+
+    // this renderer never sets pNext, depth/stencil, tessellation or dynamic state
+    auto job = std::make_unique<QueuedPipeline>();
+    job->key = key;
+    job->info = info;
+    job->stages.assign(info.pStages, info.pStages + info.stageCount);
+    job->info.pStages = job->stages.data();
+
+    job->vertexInput = *info.pVertexInputState;
+    job->bindings.assign(job->vertexInput.pVertexBindingDescriptions,
+                         job->vertexInput.pVertexBindingDescriptions +
+                         job->vertexInput.vertexBindingDescriptionCount);
+    job->attributes.assign(job->vertexInput.pVertexAttributeDescriptions,
+                           job->vertexInput.pVertexAttributeDescriptions +
+                           job->vertexInput.vertexAttributeDescriptionCount);
+    job->vertexInput.pVertexBindingDescriptions = job->bindings.data();
+    job->vertexInput.pVertexAttributeDescriptions = job->attributes.data();
+    job->info.pVertexInputState = &job->vertexInput;
+
+    job->inputAssembly = *info.pInputAssemblyState;
+    job->info.pInputAssemblyState = &job->inputAssembly;
+
+    job->viewportState = *info.pViewportState;
+    job->viewports.assign(job->viewportState.pViewports,
+                          job->viewportState.pViewports + job->viewportState.viewportCount);
+    job->scissors.assign(job->viewportState.pScissors,
+                         job->viewportState.pScissors + job->viewportState.scissorCount);
+    job->viewportState.pViewports = job->viewports.data();
+    job->viewportState.pScissors = job->scissors.data();
+    job->info.pViewportState = &job->viewportState;
+
+    job->rasterization = *info.pRasterizationState;
+    job->info.pRasterizationState = &job->rasterization;
+    job->multisample = *info.pMultisampleState;
+    job->info.pMultisampleState = &job->multisample;
+
+    job->colorBlend = *info.pColorBlendState;
+    job->blendAttachments.assign(job->colorBlend.pAttachments,
+                                 job->colorBlend.pAttachments + job->colorBlend.attachmentCount);
+    job->colorBlend.pAttachments = job->blendAttachments.data();
+    job->info.pColorBlendState = &job->colorBlend;
+
+    queue_.push_back(std::move(job));
+    return key;
+}
+
+void PipelineRegistry::compileAsync(uint32_t threadCount) {
+    if (queue_.empty()) return;
+
+    // seed the worker caches with what came off disk so a warm start still hits
+    size_t size = 0;
+    vkGetPipelineCacheData(device_, cache_, &size, nullptr);
+    std::vector<uint8_t> seed(size);
+    if (size) vkGetPipelineCacheData(device_, cache_, &size, seed.data());
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = size;
+    cacheInfo.pInitialData = size ? seed.data() : nullptr;
+
+    threadCount = std::clamp<uint32_t>(threadCount, 1, static_cast<uint32_t>(queue_.size()));
+    workerCaches_.resize(threadCount, VK_NULL_HANDLE);
+    for (auto &cache: workerCaches_) {
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+            LOGE("Failed to create worker pipeline cache");
+            throw std::runtime_error("Failed to create pipeline cache");
+        }
+    }
+
+    nextJob_ = 0;
+    compileStart_ = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&PipelineRegistry::workerLoop, this, i);
+    }
+}
+
+void PipelineRegistry::workerLoop(uint32_t workerIndex) {
+    Trace::setThreadName("pipeline worker");
+    // jobs are handed out one at a time, the main pipeline is much slower to compile than the rest
+    size_t jobIndex;
+    while ((jobIndex = nextJob_.fetch_add(1)) < queue_.size()) {
+        TRACE_SCOPE("compilePipeline");
+        QueuedPipeline &job = *queue_[jobIndex];
+        auto start = std::chrono::steady_clock::now();
+        job.result = vkCreateGraphicsPipelines(device_, workerCaches_[workerIndex], 1, &job.info,
+                                               nullptr, &job.pipeline);
+        job.compileMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void PipelineRegistry::waitCompiled() {
+    if (queue_.empty()) return;
+    TRACE_SCOPE("waitCompiled");
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    double wallMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - compileStart_).count();
+
+    vkMergePipelineCaches(device_, cache_, static_cast<uint32_t>(workerCaches_.size()),
+                          workerCaches_.data());
+    uint32_t threadCount = static_cast<uint32_t>(workerCaches_.size());
+    for (auto cache: workerCaches_) {
+        vkDestroyPipelineCache(device_, cache, nullptr);
+    }
+    workerCaches_.clear();
+
+    double serialMs = 0.0;
+    VkResult failed = VK_SUCCESS;
+    for (auto &job: queue_) {
+        serialMs += job->compileMs;
+        if (job->result != VK_SUCCESS) {
+            failed = job->result;
+            continue;
+        }
+        pipelines_[job->key] = job->pipeline;
+        job->pipeline = VK_NULL_HANDLE;
+    }
+    // wall time runs from compileAsync, so it includes whatever the caller did meanwhile
+    LOGE("Compiled %zu pipelines on %u threads: %.1f ms compiling in total, done %.1f ms after "
+         "kicking off", queue_.size(), threadCount, serialMs, wallMs);
+    queue_.clear();
+
+    if (failed != VK_SUCCESS) {
+        LOGE("Failed to create graphics pipeline! error code:%d", failed);
+        throw std::runtime_error("Failed to create graphics pipeline");
+    }
+}
+
+VkPipeline PipelineRegistry::pipeline(uint64_t key) const {
+    auto it = pipelines_.find(key);
+    return it != pipelines_.end() ? it->second : VK_NULL_HANDLE;
+}
@@ -0,0 +1,110 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_PIPELINEREGISTRY_H
+#define SPACEINVADERS3D_PIPELINEREGISTRY_H
+
+#include "GameObjectData.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Owns every graphics pipeline plus a VkPipelineCache that's persisted between launches, so the
+// driver only compiles shaders on the very first run (or after a driver update).
+// Pipelines are keyed by a hash of their create info, asking for the same state twice hands back
+// the pipeline that already exists.
+// Creation is deferred: enqueue() copies the create info, compileAsync() fans the queue out over
+// worker threads (each with its own VkPipelineCache, merged back afterwards) and waitCompiled()
+// collects the results, so the caller can load assets in between.
+class PipelineRegistry {
+public:
+    // cacheFile empty = keep the cache in memory only
+    PipelineRegistry(VkDevice device, VkPhysicalDevice physicalDevice, std::string cacheFile);
+
+    // destroys the pipelines, call save() first if the cache should be kept
+    ~PipelineRegistry();
+
+    // shaderHash identifies the SPIR-V behind info.pStages (module handles differ every run).
+    // Returns the key to look the pipeline up with after waitCompiled(). The shader modules
+    // and layout have to stay alive until then, everything else is copied
+    uint64_t enqueue(const VkGraphicsPipelineCreateInfo &info, uint64_t shaderHash);
+
+    void compileAsync(uint32_t threadCount);
+
+    // blocks until the queue is compiled, throws if any pipeline failed
+    void waitCompiled();
+
+    VkPipeline pipeline(uint64_t key) const;
+
+    bool save() const;
+
+    size_t size() const { return pipelines_.size(); }
+
+    // for pipelines created outside the registry (compute), main thread only
+    VkPipelineCache cache() const { return cache_; }
+
+    // FNV-1a, feed the previous result back in as seed to chain
+    static uint64_t hashBytes(const void *data, size_t size,
+                              uint64_t seed = 14695981039346656037ull);
+
+    static uint64_t hashState(const VkGraphicsPipelineCreateInfo &info, uint64_t shaderHash);
+
+private:
+    // a create info that owns everything it points at, so enqueue()'s caller can go out of scope
+    struct QueuedPipeline {
+        uint64_t key;
+        VkGraphicsPipelineCreateInfo info;
+        std::vector<VkPipelineShaderStageCreateInfo> stages;
+        VkPipelineVertexInputStateCreateInfo vertexInput;
+        std::vector<VkVertexInputBindingDescription> bindings;
+        std::vector<VkVertexInputAttributeDescription> attributes;
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+        VkPipelineViewportStateCreateInfo viewportState;
+        std::vector<VkViewport> viewports;
+        std::vector<VkRect2D> scissors;
+        VkPipelineRasterizationStateCreateInfo rasterization;
+        VkPipelineMultisampleStateCreateInfo multisample;
+        VkPipelineColorBlendStateCreateInfo colorBlend;
+        std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        VkResult result{VK_NOT_READY};
+        double compileMs{0.0};
+    };
+
+    // our own header in front of the driver's blob. The driver header has no driver version,
+    // and a corrupt blob is worth catching before it gets near the driver
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    VkDevice device_{VK_NULL_HANDLE};
+    VkPhysicalDeviceProperties properties_{};
+    std::string cacheFile_;
+    VkPipelineCache cache_{VK_NULL_HANDLE};
+    std::unordered_map<uint64_t, VkPipeline> pipelines_;
+    uint32_t dedupedCount_ = 0;
+    bool loadedFromDisk_ = false;
+
+    std::vector<std::unique_ptr<QueuedPipeline>> queue_;
+    std::vector<std::thread> workers_;
+    std::vector<VkPipelineCache> workerCaches_;
+    std::atomic<size_t> nextJob_{0};
+    std::chrono::steady_clock::time_point compileStart_;
+
+    std::vector<uint8_t> loadCacheData();
+
+    void workerLoop(uint32_t workerIndex);
+};
+
+
+#endif //SPACEINVADERS3D_PIPELINEREGISTRY_H
@@ -3,8 +3,6 @@
 //
 
 #include "PowerUpManager.h"
-AABB powerupBox;
-AABB shipBox;
 //AABB getAABB(float cx, float cy, float width, float height) {
 //    float halfW = width * 0.5f;
 //    float halfH = height * 0.5f;
@@ -17,68 +15,58 @@ AABB shipBox;
 //}
 
 void PowerUpManager::spawnPowerUp(PowerUpType type, const glm::vec2 &pos) {
-    float randomChance = rand() / float(RAND_MAX);
+    float randomChance = Util::getRandomFloat(0.0f, 1.0f);
     if (randomChance < 0.1f) { // 10% chance
-        PowerUpData p{};
-        p.type = (rand() % 2 == 0) ? PowerUpType::DoubleShot : PowerUpType::Shield;
-        p.pos = glm::vec3(pos.x, pos.y,0.0f); // Spawn at alien’s last position
-        p.fallSpeed = 0.3f + 0.2f * (rand() / float(RAND_MAX)); // vary slightly
-        p.active = true;
-        powerUps_.push_back(p);
+        bool doubleShot = Util::getRandomUint(0, 1) == 0;
+        float fallSpeed = 0.3f + 0.2f * Util::getRandomFloat(0.0f, 1.0f); // vary slightly
+        std::array<float, 2> size = Util::getQuadWidthHeight(quadVerts, 6, {1, 1});
+        // Spawn at alien’s last position
+        uint32_t index = entities->create(
+                doubleShot ? EntityType::DoubleShotPowerUp : EntityType::ShieldPowerUp, pos,
+                {0.0f, -fallSpeed}, {size[0], size[1]});
+        EntityRender &render = entities->render(index);
+        render.texture = doubleShot ? GameTextureType::DoubleShot : GameTextureType::Shield;
+        render.pulse = true;
     }
 }
 
 void PowerUpManager::updatePowerUpData() {
     updatePowerUpExpiry();
-    for (auto& p : powerUps_) {
-        if (!p.active) continue;
-        p.pos.y -= p.fallSpeed * Time::deltaTime; // Move downwards
-        // Deactivate if off-screen
-        if (p.pos.y < -1.1f){
-            p.active = false;
-        }
-
-    }
+    // one clock for the pulse, used to be bumped once per power-up while recording
+    pulseTime_ += Time::deltaTime;
+    // the store moves them, only the off-screen ones are left to us
+    entities->forEach(POWER_UP_MASK, [this](uint32_t i) {
+        if (entities->position(i).y < -1.1f) entities->destroyAt(i);
+    });
 
 }
 
 PowerUpManager::PowerUpManager(){
 
 }
-float elapsedTime =0.0f;
-void PowerUpManager::recordCommandBuffer(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout,
-                                         VkPipeline pipeline,
-                                         glm::vec2 shakeOffset,
-                                         VkDescriptorSet descriptorSet) {
-
-    for (auto powerUp:powerUps_) {
-        elapsedTime += Time::deltaTime;
-        MainPushConstants pushConstants = {};
-        pushConstants.pos = {powerUp.pos.x, -powerUp.pos.y};
-        pushConstants.shakeOffset = shakeOffset;
-        pushConstants.time = elapsedTime;
-        pushConstants.canPulse = 1;
-        if(powerUp.type == PowerUpType::DoubleShot) pushConstants.texturePos = 3;
-        if(powerUp.type == PowerUpType::Shield) pushConstants.texturePos = 4;
-
-
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
-                                &descriptorSet, 0, nullptr);
-        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MainPushConstants),&pushConstants);
-
-        vkCmdBindVertexBuffers(cmd, 0, 1, &powerUpBuffer, offsets);
-        vkCmdDraw(cmd, 6, 1, 0, 0);
+void PowerUpManager::addSprites(SpriteBatch &spriteBatch, VkPipeline pipeline,
+                                VkDescriptorSet descriptorSet, const TextureArray &textures,
+                                glm::vec2 shakeOffset) {
+
+    const EntityStore &store = *entities;
+    store.forEach(POWER_UP_MASK, [&](uint32_t i) {
+        const EntityRender &render = store.render(i);
+        SpriteInstance sprite = {};
+        glm::vec2 pos = store.interpolated(i, Time::alpha);
+        sprite.pos = {pos.x, -pos.y};
+        sprite.shakeOffset = shakeOffset;
+        sprite.time = pulseTime_;
+        sprite.canPulse = render.pulse ? 1 : 0;
+        sprite.scale = render.scale;
+        sprite.setTexture(textures.region(render.texture));
+
+        spriteBatch.add(pipeline, descriptorSet, sprite);
 //        util->recordDrawBoundingBox(cmd_, powerupBox, {0.0f, 1.0f, 0.0f});
-    }
+    });
 
 
 //    util->recordDrawBoundingBox(cmd_, shipBox, {1.0f, 0.0f, 0.0f});
 
-
-
-
 }
 
 void PowerUpManager::activatePowerUp(PowerUpType type) {
@@ -108,21 +96,14 @@ void PowerUpManager::updatePowerUpExpiry() {
         shieldTimer -= Time::deltaTime;
         if (shieldTimer <= 0.0f) shieldActive = false;
     }
-    powerUps_.erase(std::remove_if(powerUps_.begin(), powerUps_.end(),
-                                   [](const PowerUpData& p) { return !p.active; }),
-                    powerUps_.end());
 }
 
-void PowerUpManager::checkIfPowerUpCollected(Ship ship) {
-    for (auto& powerup : powerUps_) {
-        if (!powerup.active) continue;
-
-         powerupBox = Collision::getAABB(powerup.pos.x, -powerup.pos.y, powerup.widthHeight[0], powerup.widthHeight[1]);
-         shipBox    = Collision::getAABB(ship.x, ship.y, ship.widthHeight[0], ship.widthHeight[1]);
-
-        if (Collision::isColliding(powerupBox, shipBox)) {
-            powerup.active = false;
-            activatePowerUp(powerup.type);
-        }
-    }
+void PowerUpManager::collect(uint32_t index, const AABB &shipBox) {
+    glm::vec2 step = entities->step(index);
+    float timeOfImpact;
+    if (!Collision::sweep(entities->startBounds(index), step.x, step.y, shipBox, timeOfImpact))
+        return;
+    entities->destroyLater(index);
+    activatePowerUp(entities->type(index) == EntityType::DoubleShotPowerUp
+                    ? PowerUpType::DoubleShot : PowerUpType::Shield);
 }
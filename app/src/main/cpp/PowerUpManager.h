@@ -9,36 +9,35 @@
 #include "Time.h"
 #include "Util.h"
 #include "Collision.h"
-
-struct PowerUpData {
-    PowerUpType type;
-    glm::vec3 pos;      // NDC or world units
-    std::array<float,2> widthHeight = Util::getQuadWidthHeight(quadVerts,6,{1,1});
-    float fallSpeed;    // e.g., 0.5f per sec
-    float timeLeft;     // for active power-ups, e.g. 5.0f
-    bool active;
-};
+#include "SpriteBatch.h"
+#include "TextureArray.h"
+#include "EntityStore.h"
 
 class PowerUpManager {
 private:
 
     void updatePowerUpExpiry();
     void activatePowerUp(PowerUpType type);
-    std::vector<PowerUpData> powerUps_;
+    float pulseTime_ = 0.0f;
 public:
     std::shared_ptr<Util> util;
+    // the falling power-ups live here as DoubleShotPowerUp/ShieldPowerUp entities
+    std::shared_ptr<EntityStore> entities;
     VkDevice device;
     bool doubleShotActive = false;
     float doubleShotTimer = 0.0f;
     bool shieldActive = false;
     float shieldTimer = 0.0f;
-    VkBuffer powerUpBuffer;
-    VkDeviceMemory powerUpBufferMemory;
     explicit PowerUpManager();
     void spawnPowerUp(PowerUpType type, const glm::vec2& pos);
     void updatePowerUpData();
-    void checkIfPowerUpCollected(Ship ship);
-    void recordCommandBuffer(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout,VkPipeline pipeline,glm::vec2 shakeOffset,VkDescriptorSet descriptorSet);
+    static constexpr uint32_t POWER_UP_MASK = entityMask(EntityType::DoubleShotPowerUp) |
+                                              entityMask(EntityType::ShieldPowerUp);
+    // activates the power-up entity at index if its last step actually crossed shipBox. It's
+    // destroyed through destroyLater(), so indices stay valid until the caller flushes
+    void collect(uint32_t index, const AABB &shipBox);
+    void addSprites(SpriteBatch &spriteBatch, VkPipeline pipeline, VkDescriptorSet descriptorSet,
+                    const TextureArray &textures, glm::vec2 shakeOffset);
 };
 
 
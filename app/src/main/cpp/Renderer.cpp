@@ -1,6 +1,9 @@
 #include "Renderer.h"
+#ifdef __ANDROID__
 #include "SimpleSFXPlayer.h"
+#endif
 #include "SFXMixer.h"
+#include "Trace.h"
 
 #define DR_WAV_IMPLEMENTATION
 
@@ -14,8 +17,13 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <stb_image.h>
+#ifdef __ANDROID__
 #include <android/native_window.h>
+#include <sys/system_properties.h>
+#endif
 #include <vector>
+#include <chrono>
+#include <thread>
 #include <stdexcept>
 
 std::unordered_map<GameText, std::pair<VkBuffer, std::vector<Vertex>>> allTextVertices;
@@ -35,46 +43,35 @@ const bool enableValidationLayers = true;
 #endif
 
 
-Bullet bullets_[MAX_BULLETS] = {};
-Ship ship_ = {
-        .widthHeight = Util::getQuadWidthHeight(shipVerts, 6, {1, 1})
-};
-Alien aliens_[MAX_ALIENS] = {};
+const std::array<float, 2> shipSize_ = Util::getQuadWidthHeight(shipVerts, 6, {1, 1});
+const std::array<float, 2> bulletSize_ = Util::getQuadWidthHeight(quadVerts, 6, {0.2, 0.5});
+const float shipHaloSize_ = 0.1f;
+AlienFormation aliens_(NUM_ALIENS_X, NUM_ALIENS_Y, {-0.7f, 0.8f}, {0.2f, 0.15f},
+                       Util::getQuadWidthHeight(alienVerts, 6, {0.5, 0.5}));
 
-float alienMoveSpeed_ = 0.3f;
+// globals outlive the Renderer, init() puts this back so a new one (or a replay) starts fresh
+const float alienStartSpeed_ = 0.3f;
+float alienMoveSpeed_ = alienStartSpeed_;
 float bulletMoveSpeed_ = 2.0f;
-float alienDirection_ = 1.0f; // 1 = right, -1 = left
-
-
-std::vector<char> loadShaderAsset(AAssetManager *mgr, const char *filename);
 
-VkShaderModule createShaderModule(VkDevice device, const std::vector<char> &code);
 
-void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size,
+void createBuffer(VkDevice device, MemoryAllocator &allocator, VkDeviceSize size,
                   VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer,
-                  VkDeviceMemory &bufferMemory);
+                  MemoryAllocation &bufferMemory);
 
 
-bool isCollision(const Alien &alien, const Bullet &bullet);
-
 void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageView &imageView);
 
-void createImage(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height,
+void createImage(VkDevice device, MemoryAllocator &allocator, uint32_t width, uint32_t height,
                  VkFormat format,
                  VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-                 VkImage &image, VkDeviceMemory &imageMemory);
-
-void transitionImageLayout(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue,
-                           VkImage image, VkFormat format, VkImageLayout oldLayout,
-                           VkImageLayout newLayout);
-
-void copyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue,
-                       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+                 VkImage &image, MemoryAllocation &imageMemory);
 
-void createTextureSampler(VkDevice device, VkSampler &sampler, GameTextureType type);
+unsigned char *decodeImageAsset(const AssetLoader &assets, const std::string &path, int &width,
+                                int &height);
 
 void
-setShaderStages(VkDevice device, AAssetManager *assetManager, const char *spirvVertexFilename,
+setShaderStages(ShaderModuleCache &shaderModules, const char *spirvVertexFilename,
                 const char *spirvFragmentFilename,
                 GfxPipelineData &graphicsPipelineData);
 
@@ -88,11 +85,8 @@ void setRasterizer(GfxPipelineData &graphicsPipelineData);
 
 void setSampling(GfxPipelineData &graphicsPipelineData);
 
-void updateFontBuffer(VkDevice device, std::vector<Vertex> textVertices,
-                      VkDeviceMemory fontVertexBufferMemory_);
-
-void uploadDataBuffer(VkDevice device, const void *dataToUpload, VkDeviceSize sizeOfData,
-                      VkDeviceMemory bufferMemory);
+void updateFontBuffer(const std::vector<Vertex> &textVertices,
+                      const MemoryAllocation &fontVertexBufferMemory);
 
 std::vector<float>
 decodeWAV(const std::vector<uint8_t> &wavBytes, int &outChannels, int &outSampleRate);
@@ -100,7 +94,7 @@ decodeWAV(const std::vector<uint8_t> &wavBytes, int &outChannels, int &outSample
 std::vector<float>
 decodeMP3(const std::vector<uint8_t> &mp3Bytes, int &outChannels, int &outSampleRate);
 
-std::vector<uint8_t> loadMusicAssetToMemory(AAssetManager *mgr, const char *filename);
+std::vector<uint8_t> loadMusicAssetToMemory(const AssetLoader &assets, const char *filename);
 
 VkResult CreateDebugUtilsMessengerEXT(VkInstance instance,
                                       const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo,
@@ -125,53 +119,22 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 }
 
 
-VkShaderModule createShaderModule(VkDevice device, const std::vector<char> &code) {
-    VkShaderModuleCreateInfo createInfo = {};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-        LOGE("Failed to create shader module");
-        throw std::runtime_error("Failed to create shader module");
-    }
-    return shaderModule;
-}
-
-inline bool isCollision(const Alien &alien, const Bullet &bullet) {
-
-    if (bullet.bulletType == BulletType::Ship) {
-        auto alienAABB = Collision::getAABB(alien.x, alien.y, alien.widthHeight[0],
-                                            alien.widthHeight[1]);
-        auto bulletAABB = Collision::getAABB(bullet.x, -bullet.y, bullet.widthHeight[0],
-                                             bullet.widthHeight[1]);
+constexpr uint32_t BULLET_MASK = entityMask(EntityType::ShipBullet) |
+                                 entityMask(EntityType::AlienBullet);
 
-        return Collision::isColliding(alienAABB, bulletAABB);
-    } else if (bullet.bulletType == BulletType::Alien) {
-        return false;
-    }
-    return false;
-}
-
-std::vector<char> loadShaderAsset(AAssetManager *mgr, const char *filename) {
-    std::string fullPath = "shaders/" + std::string(filename);
-    AAsset *asset = AAssetManager_open(mgr, fullPath.c_str(), AASSET_MODE_STREAMING);
-    size_t size = AAsset_getLength(asset);
-    std::vector<char> buffer(size);
-    AAsset_read(asset, buffer.data(), size);
-    AAsset_close(asset);
-    return buffer;
+// bullets fly straight up or down at speed, in alien space like every entity
+void addBullet(EntityStore &entities, EntityType type, glm::vec2 pos, float speed) {
+    uint32_t bullet = entities.create(type, pos, {0.0f, speed}, {bulletSize_[0], bulletSize_[1]});
+    EntityRender &render = entities.render(bullet);
+    render.texture = GameTextureType::ShipBullet;
+    render.scale = {0.5f, 0.5f};
 }
 
 
-std::vector<uint8_t> loadMusicAssetToMemory(AAssetManager *mgr, const char *filename) {
+std::vector<uint8_t> loadMusicAssetToMemory(const AssetLoader &assets, const char *filename) {
     std::string fullPath = "audio/" + std::string(filename);
-    AAsset *asset = AAssetManager_open(mgr, fullPath.c_str(), AASSET_MODE_STREAMING);
-    if (!asset) throw std::runtime_error("Asset not found!");
-    size_t fileSize = AAsset_getLength(asset);
-    std::vector<uint8_t> data(fileSize);
-    AAsset_read(asset, data.data(), fileSize);
-    AAsset_close(asset);
+    std::vector<uint8_t> data = assets.load(fullPath);
+    if (data.empty()) throw std::runtime_error("Asset not found!");
     LOGE("Asset scale: %zu", data.size());
     return data;
 }
@@ -215,9 +178,29 @@ decodeMP3(const std::vector<uint8_t> &mp3Bytes, int &outChannels, int &outSample
 }
 
 
-void Renderer::loadTexture(const char *filename, VkImage &vkImage, VkDeviceMemory &vkDeviceMemory,
+// RGBA8, free the result with stbi_image_free
+unsigned char *decodeImageAsset(const AssetLoader &assets, const std::string &path, int &width,
+                                int &height) {
+    LOGE("file path:%s", path.c_str());
+    std::vector<uint8_t> fileData = assets.load(path);
+    if (fileData.empty()) {
+        LOGE("failed to load assset: %s", path.c_str());
+        return nullptr;
+    }
+
+    int channels;
+    unsigned char *decoded = stbi_load_from_memory(fileData.data(), fileData.size(), &width,
+                                                   &height, &channels, STBI_rgb_alpha);
+    if (!decoded) {
+        LOGE("failed to decode asset: %s", path.c_str());
+    }
+    return decoded;
+}
+
+void Renderer::loadTexture(const char *filename, VkImage &vkImage, MemoryAllocation &vkDeviceMemory,
                            VkImageView &imageView, VkSampler &vkSampler,
                            GameTextureType gameTextureType) {
+    TRACE_SCOPE("loadTexture");
     std::string fullPath;
     if (gameTextureType == GameTextureType::FontAtlas) {
         fullPath = "fonts/" + std::string(filename);
@@ -225,33 +208,11 @@ void Renderer::loadTexture(const char *filename, VkImage &vkImage, VkDeviceMemor
         fullPath = "textures/" + std::string(filename);
     }
 
-    LOGE("file path:%s", fullPath.c_str());
-    std::vector<uint8_t> pixelData;
     int textureWidth, textureHeight;
-//    AAsset *asset = AAssetManager_open(assetManager_, "textures/alien_ship_1.png", AASSET_MODE_STREAMING);
-    AAsset *asset = AAssetManager_open(assetManager_, fullPath.c_str(), AASSET_MODE_STREAMING);
-    bool imageIsLoaded = true;
-    if (!asset) {
-        LOGE("failed to load assset: %s", fullPath.c_str());
-        imageIsLoaded = false;
-    }
-
-    size_t fileLength = AAsset_getLength(asset);
-    std::vector<uint8_t> fileData(fileLength);
-    AAsset_read(asset, fileData.data(), fileLength);
-    AAsset_close(asset);
-
-
-    int channels;
-    unsigned char *decoded = stbi_load_from_memory(fileData.data(), fileLength, &textureWidth,
-                                                   &textureHeight,
-                                                   &channels, STBI_rgb_alpha);
-
-    if (!decoded) imageIsLoaded = false;
-
-    pixelData.assign(decoded, decoded + textureWidth * textureHeight * 4);
-
-    stbi_image_free(decoded);
+    unsigned char *decoded = decodeImageAsset(*assetLoader_, fullPath, textureWidth,
+                                              textureHeight);
+    if (!decoded) return;
+    VkDeviceSize imageSize = textureWidth * textureHeight * 4;
 
     if (gameTextureType == GameTextureType::FontAtlas) {
         // 2. Describe your atlas grid
@@ -259,62 +220,44 @@ void Renderer::loadTexture(const char *filename, VkImage &vkImage, VkDeviceMemor
 
 // 3. Auto-scan metrics:
         LOGE("width:%i x hieght:%i", textureWidth, textureHeight);
+        std::vector<uint8_t> pixelData(decoded, decoded + imageSize);
         fontManager_->autoPackFontAtlas(pixelData, textureWidth, textureHeight,
                                         cellW, cellH, cols, rows);
     }
 
-    if (imageIsLoaded) {
-        LOGE("loading image asset:%s", filename);
-        VkBuffer stagingBuffer{VK_NULL_HANDLE};
-        VkDeviceMemory stagingBufferMemory{VK_NULL_HANDLE};
-        // 1. Create staging buffer & copy image data
-        // (Create staging buffer, copy data, omitted for brevity)
-        VkDeviceSize imageSize = textureWidth * textureHeight * 4;
-        createBuffer(device_, physicalDevice_, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                     stagingBuffer, stagingBufferMemory);
-
-        void *imageData;
-        vkMapMemory(device_, stagingBufferMemory, 0, imageSize, 0, &imageData);
-        memcpy(imageData, pixelData.data(), imageSize);
-        vkUnmapMemory(device_, stagingBufferMemory);
-
+    LOGE("loading image asset:%s", filename);
+    // 1. Copy the decoded pixels into the shared staging arena, the copy itself is batched
+    UploadContext::Staging staging = uploadContext_->allocateStaging(imageSize);
+    memcpy(staging.data, decoded, imageSize);
+    stbi_image_free(decoded);
 
 // 2. Create the Vulkan image (device local)
-        createImage(device_, physicalDevice_, textureWidth, textureHeight, VK_FORMAT_R8G8B8A8_UNORM,
-                    VK_IMAGE_TILING_OPTIMAL,
-                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vkImage, vkDeviceMemory);
-// 3. Copy from staging buffer to Vulkan image (with transitions)
-        transitionImageLayout(device_, commandPool_, graphicsQueue_, vkImage,
-                              VK_FORMAT_R8G8B8A8_UNORM,
-                              VK_IMAGE_LAYOUT_UNDEFINED,
-                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-        copyBufferToImage(device_, commandPool_, graphicsQueue_, stagingBuffer, vkImage,
-                          textureWidth, textureHeight);
-
-
-        transitionImageLayout(device_, commandPool_, graphicsQueue_, vkImage,
-                              VK_FORMAT_R8G8B8A8_UNORM,
-                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-// 4. Create image view and sampler
-        createImageView(device_, vkImage, VK_FORMAT_R8G8B8A8_UNORM, imageView);
-        createTextureSampler(device_, vkSampler, gameTextureType);
-
-        vkDestroyBuffer(device_, stagingBuffer, nullptr);
-        vkFreeMemory(device_, stagingBufferMemory, nullptr);
+    createImage(device_, *allocator_, textureWidth, textureHeight, VK_FORMAT_R8G8B8A8_UNORM,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vkImage, vkDeviceMemory);
+// 3. Queue the copy + transitions, they go out with the rest in uploadContext_->submit()
+    uploadContext_->uploadImage(vkImage, textureWidth, textureHeight, staging);
+// 4. Create image view, the sampler is shared with everything else using the same state
+    createImageView(device_, vkImage, VK_FORMAT_R8G8B8A8_UNORM, imageView);
+    vkSampler = samplerCache_->get(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+}
 
-    } else {
-        LOGE("failed to load overlay image");
-    }
+void Renderer::loadSpriteTexture(const char *filename, GameTextureType gameTextureType) {
+    TRACE_SCOPE("loadSpriteTexture");
+    int textureWidth, textureHeight;
+    unsigned char *decoded = decodeImageAsset(*assetLoader_, "textures/" + std::string(filename),
+                                              textureWidth, textureHeight);
+    if (!decoded) return;
+    spriteTextures_->addLayer(gameTextureType, decoded, textureWidth, textureHeight,
+                              *uploadContext_);
+    stbi_image_free(decoded);
 }
 
-// Create a Vulkan buffer
-void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size,
+// Create a Vulkan buffer, memory comes out of the shared allocator
+void createBuffer(VkDevice device, MemoryAllocator &allocator, VkDeviceSize size,
                   VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer,
-                  VkDeviceMemory &bufferMemory) {
+                  MemoryAllocation &bufferMemory) {
 
     VkBufferCreateInfo bufferInfo = {};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -330,33 +273,14 @@ void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-
-    // Find memory type
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((memRequirements.memoryTypeBits & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            allocInfo.memoryTypeIndex = i;
-            break;
-        }
-    }
-
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        LOGE("Failed to allocate buffer memory");
-        throw std::runtime_error("Failed to allocate buffer memory");
-    }
-
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    bufferMemory = allocator.allocate(memRequirements, properties, true);
+    vkBindBufferMemory(device, buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
-void createImage(VkDevice device, VkPhysicalDevice physicalDevice,
+void createImage(VkDevice device, MemoryAllocator &allocator,
                  uint32_t width, uint32_t height, VkFormat format,
                  VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-                 VkImage &image, VkDeviceMemory &imageMemory) {
+                 VkImage &image, MemoryAllocation &imageMemory) {
 
     VkImageCreateInfo imageInfo = {};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -378,137 +302,9 @@ void createImage(VkDevice device, VkPhysicalDevice physicalDevice,
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    // Find proper memory type
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((memRequirements.memoryTypeBits & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            allocInfo.memoryTypeIndex = i;
-            break;
-        }
-    }
-    vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory);
-    vkBindImageMemory(device, image, imageMemory, 0);
-}
-
-void transitionImageLayout(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue,
-                           VkImage image, VkFormat format, VkImageLayout oldLayout,
-                           VkImageLayout newLayout) {
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    VkImageMemoryBarrier barrier = {};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags srcStage, dstStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
-        newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-               newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-
-    vkCmdPipelineBarrier(
-            commandBuffer,
-            srcStage, dstStage,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier
-    );
-
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-}
-
-void copyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue,
-                       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    VkBufferImageCopy region = {};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {width, height, 1};
-
-    vkCmdCopyBufferToImage(
-            commandBuffer,
-            buffer,
-            image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1,
-            &region
-    );
-
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    imageMemory = allocator.allocate(memRequirements, properties,
+                                     tiling == VK_IMAGE_TILING_LINEAR);
+    vkBindImageMemory(device, image, imageMemory.memory, imageMemory.offset);
 }
 
 void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageView &imageView) {
@@ -526,91 +322,183 @@ void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageVie
     vkCreateImageView(device, &viewInfo, nullptr, &imageView);
 }
 
-void createTextureSampler(VkDevice device, VkSampler &sampler, GameTextureType type) {
-    VkSamplerCreateInfo samplerInfo = {};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    if (type == GameTextureType::FontAtlas) {
-        samplerInfo.magFilter = VK_FILTER_LINEAR;
-        samplerInfo.minFilter = VK_FILTER_LINEAR;
-
-    } else {
-        samplerInfo.magFilter = VK_FILTER_LINEAR;
-        samplerInfo.minFilter = VK_FILTER_LINEAR;
-    }
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.anisotropyEnable = VK_FALSE;
-    samplerInfo.maxAnisotropy = 1.0f;
-    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerInfo.unnormalizedCoordinates = VK_FALSE;
-    samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-
-    vkCreateSampler(device, &samplerInfo, nullptr, &sampler);
-}
-
+#ifdef __ANDROID__
 SimpleSFXPlayer player;
+#endif
 SFXMixer sfxMixer;
 
 
 void Renderer::stopAudioPlayer() {
+#ifdef __ANDROID__
     sfxMixer.stream->stop();
     if (player.stream) {
         player.stream->stop();
     }
+#endif
 }
 
 void Renderer::resumeAudioPlayer() {
+#ifdef __ANDROID__
     sfxMixer.stream->start();
     if (player.stream) {
         player.stream->start();
     }
+#endif
 }
 
 std::vector<float> shootSFXSample, explodeSFXSample1, explodeSFXSample2;
 std::unordered_map<uint, std::vector<float>> explosionSFXMap;
 
-Renderer::Renderer(android_app *app) : app_(app) {
+#ifdef __ANDROID__
+Renderer::Renderer(android_app *app, uint32_t framesInFlight)
+        : app_(app),
+          assetLoader_(std::make_unique<AssetLoader>(app->activity->assetManager)),
+          framesInFlight_(std::clamp<uint32_t>(framesInFlight, 1, MAX_FRAMES_IN_FLIGHT)) {
+    if (app->activity->internalDataPath)
+        pipelineCacheDir_ = app->activity->internalDataPath;
+    // adb shell setprop debug.spaceinvaders3d.trace 1, then adb pull the trace.json it writes
+    char traceProp[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.spaceinvaders3d.trace", traceProp) > 0 &&
+        traceProp[0] == '1' && !pipelineCacheDir_.empty()) {
+        traceFile_ = pipelineCacheDir_ + "/trace.json";
+        Trace::setEnabled(true);
+    }
+    init();
+    // adb shell setprop debug.spaceinvaders3d.hud 1
+    char hudProp[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.spaceinvaders3d.hud", hudProp) > 0 && hudProp[0] == '1')
+        enablePerfHud();
+    // adb shell setprop debug.spaceinvaders3d.tickrate 120, gameplay ticks per second
+    char tickProp[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.spaceinvaders3d.tickrate", tickProp) > 0)
+        Time::setTickRate(std::strtof(tickProp, nullptr));
+    // adb shell setprop debug.spaceinvaders3d.renderthread 0 records on the game thread again
+    bool renderThread = std::thread::hardware_concurrency() > 1;
+    char renderThreadProp[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.spaceinvaders3d.renderthread", renderThreadProp) > 0)
+        renderThread = renderThreadProp[0] == '1';
+    if (renderThread) startRenderThread();
+    // adb shell setprop debug.spaceinvaders3d.jobworkers 0 runs the update phases inline,
+    // debug.spaceinvaders3d.pinjobs 1 pins the workers to the fastest cores
+    char workersProp[PROP_VALUE_MAX] = {};
+    char pinProp[PROP_VALUE_MAX] = {};
+    bool customWorkers = __system_property_get("debug.spaceinvaders3d.jobworkers", workersProp) > 0;
+    bool pinWorkers = __system_property_get("debug.spaceinvaders3d.pinjobs", pinProp) > 0 &&
+                      pinProp[0] == '1';
+    if (customWorkers || pinWorkers) {
+        uint32_t workers = customWorkers ? uint32_t(std::strtoul(workersProp, nullptr, 10))
+                                         : JobSystem::defaultWorkerCount();
+        startJobSystem(workers, pinWorkers);
+    }
+}
+#endif
 
+Renderer::Renderer(const std::string &assetDir, uint32_t width, uint32_t height,
+                   uint32_t framesInFlight, const std::string &pipelineCacheDir)
+        : assetLoader_(std::make_unique<AssetLoader>(assetDir)),
+          headless_(true),
+          pipelineCacheDir_(pipelineCacheDir),
+          framesInFlight_(std::clamp<uint32_t>(framesInFlight, 1, MAX_FRAMES_IN_FLIGHT)) {
+    swapchainExtent_ = {width, height};
+    init();
+}
+
+void Renderer::init() {
+    Trace::setThreadName("main");
+    TRACE_SCOPE("Renderer::init");
+    auto initStart = std::chrono::steady_clock::now();
     initVulkan();
-    assetManager_ = app_->activity->assetManager;
     fontManager_ = std::make_unique<FontManager>();
     util_ = std::make_shared<Util>();
     powerUpManager_ = std::make_shared<PowerUpManager>();
     particleSystem_ = std::make_unique<ParticleSystem>(device_, powerUpManager_);
+    shakeRng_.seed(Util::getRandomUint(0, UINT32_MAX));
+    alienMoveSpeed_ = alienStartSpeed_;
     util_->device = device_;
     powerUpManager_->util = util_;
 
     powerUpManager_->device = device_;
-    loadAllTextures();
-    loadText();
-    loadGameObjects();
-    createUniformBuffer();
-    initAliens();
-
+    entities_ = std::make_shared<EntityStore>(ENTITY_START_CAPACITY);
+    powerUpManager_->entities = entities_;
+    startJobSystem(JobSystem::defaultWorkerCount(), false);
+    samplerCache_ = std::make_unique<SamplerCache>(device_);
+    shaderModules_ = std::make_unique<ShaderModuleCache>(device_, *assetLoader_);
+
+    // pipelines only need layouts and shader modules, so they get queued first and compile on
+    // worker threads while textures, buffers and audio load below
     createMainGfxPipeline();
     createOverlayGfxPipeline();
     createFontGfxPipeline();
 
     createParticlesGfxPipeline(GfxPipelineType::ExplosionParticles);
-    createParticlesGfxPipeline(GfxPipelineType::StarParticles);
+    // the instanced star field is only the fallback for when the procedural shader isn't built
+    particleSystem_->proceduralStars = assetLoader_->exists("shaders/stars_procedural.vert.spv");
+    if (particleSystem_->proceduralStars)
+        createParticlesGfxPipeline(GfxPipelineType::ProceduralStars);
+    else
+        createParticlesGfxPipeline(GfxPipelineType::StarParticles);
     createParticlesGfxPipeline(GfxPipelineType::HaloEffect);
+    // falls back to the CPU particles if the queue can't do compute or the shader isn't built
+    bool gpuParticles = GpuParticles::supported(physicalDevice_, graphicsQueueFamily_) &&
+                        assetLoader_->exists("shaders/particles_simulate.comp.spv");
+    if (gpuParticles)
+        createParticlesGfxPipeline(GfxPipelineType::GpuExplosionParticles);
 
     createGfxPipeline(GfxPipelineType::AxisAlignedBoundingBoxes);
+    pipelines_->compileAsync(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    if (gpuParticles) {
+        gpuParticles_ = std::make_unique<GpuParticles>(device_, *allocator_, pipelines_->cache(),
+                                                       *shaderModules_, GPU_PARTICLE_CAPACITY);
+        particleSystem_->gpuParticles = gpuParticles_.get();
+    }
+
+    loadAllTextures();
+    shipSprite_.setTexture(spriteTextures_->region(GameTextureType::Ship));
+    loadText();
+    createUploadRing();
+    loadGameObjects();
+    // every texture and static buffer goes out in one submission, nothing waits on it here
+    uploadContext_->submit();
+    createUniformBuffer();
+    initAliens();
+    writeDescriptorSets();
+
+    loadAudio();
+
+    finishPipelines();
+    for (uint32_t i = 0; i < TripleBuffer<FrameSnapshot>::SLOT_COUNT; ++i)
+        snapshots_.slot(i).sprites = SpriteBatch(mainPipelineLayout_);
+    allocator_->logStats();
+    LOGE("Renderer init took %.1f ms", std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - initStart).count());
+
+    sfxMixer.start(SFX_SAMPLE_RATE, SFX_CHANNELS);
+
+//    player.buffer = std::move(bgSamples);
+//    player.start(sampleRate);
+
+//    player.play();
+
 
+}
+
+void Renderer::loadAudio() {
+    TRACE_SCOPE("loadAudio");
     // 1. Load file from assets
-    std::vector<uint8_t> shootSFX = loadMusicAssetToMemory(assetManager_, "shoot.wav");
-    std::vector<uint8_t> bgMusicBytes = loadMusicAssetToMemory(assetManager_, "space-invaders.mp3");
-    std::vector<uint8_t> explosionBytes1 = loadMusicAssetToMemory(assetManager_, "explode_1.wav");
-    std::vector<uint8_t> explosionBytes2 = loadMusicAssetToMemory(assetManager_, "explode_2.wav");
+    std::vector<uint8_t> shootSFX = loadMusicAssetToMemory(*assetLoader_, "shoot.wav");
+    std::vector<uint8_t> explosionBytes1 = loadMusicAssetToMemory(*assetLoader_, "explode_1.wav");
+    std::vector<uint8_t> explosionBytes2 = loadMusicAssetToMemory(*assetLoader_, "explode_2.wav");
 
 
 // 2. Decode WAV to float samples
     int channels, sampleRate;
-    auto bgSamples = decodeMP3(bgMusicBytes, channels, sampleRate);
-    if (sampleRate != SFX_SAMPLE_RATE || channels != SFX_CHANNELS) {
-        LOGE("bgSamples SFX file must be 44100 Hz mono!");
+    // background music is optional (not shipped in assets/audio at the moment)
+    if (assetLoader_->exists("audio/space-invaders.mp3")) {
+        auto bgSamples = decodeMP3(loadMusicAssetToMemory(*assetLoader_, "space-invaders.mp3"),
+                                   channels, sampleRate);
+        if (sampleRate != SFX_SAMPLE_RATE || channels != SFX_CHANNELS) {
+            LOGE("bgSamples SFX file must be 44100 Hz mono!");
+        }
     }
 
     shootSFXSample = decodeWAV(shootSFX, channels, sampleRate);
@@ -630,34 +518,25 @@ Renderer::Renderer(android_app *app) : app_(app) {
     }
     explosionSFXMap[0] = explodeSFXSample1;
     explosionSFXMap[1] = explodeSFXSample2;
-
-    sfxMixer.start(SFX_SAMPLE_RATE, SFX_CHANNELS);
-
-//    player.buffer = std::move(bgSamples);
-//    player.start(sampleRate);
-
-//    player.play();
-
-
 }
 
 void Renderer::loadAllTextures() {
+    TRACE_SCOPE("loadAllTextures");
+
+    // every main pipeline sprite samples the one array, new art is just another layer here
+    spriteTextures_ = std::make_unique<TextureArray>(device_, *allocator_);
+    loadSpriteTexture("ke_ship_1.png", GameTextureType::Ship);
+    loadSpriteTexture("alien_ship_1.png", GameTextureType::Alien);
+    loadSpriteTexture("laser_2.png", GameTextureType::ShipBullet);
+    loadSpriteTexture("double_shot_2.png", GameTextureType::DoubleShot);
+    loadSpriteTexture("shield.png", GameTextureType::Shield);
+    spriteTextures_->build(*uploadContext_);
 
-    loadTexture("ke_ship_1.png", shipImage_, shipImageDeviceMemory_, shipImageView_, shipSampler_,
-                GameTextureType::Ship);
-    loadTexture("alien_ship_1.png", alienImage_, alienImageDeviceMemory_, alienImageView_,
-                alienSampler_, GameTextureType::Alien);
-    loadTexture("laser_2.png", shipBulletImage_, shipBulletImageDeviceMemory_, shipBulletImageView_,
-                shipBulletSampler_, GameTextureType::ShipBullet);
     loadTexture("tap_to_restart_2.png", overlayImage_, overlayImageDeviceMemory_, overlayImageView_,
                 overlaySampler_, GameTextureType::Overlay);
     loadTexture("8bitOperatorBold.png", fontAtlasImage_, fontAtlasImageDeviceMemory_,
                 fontAtlasImageView_, fontAtlasSampler_,
                 GameTextureType::FontAtlas);
-    loadTexture("double_shot_2.png", doubleShotImage_, doubleShotMemory_, doubleShotView_,
-                doubleShotSampler_, GameTextureType::PowerUp);
-    loadTexture("shield.png", shieldImage_, shieldMemory_, shieldView_, shieldSampler_,
-                GameTextureType::PowerUp);
 
 }
 
@@ -715,22 +594,6 @@ void Renderer::createImageOverlayDescriptor(GfxPipelineData &gfxPipelineData) {
 
 
     vkAllocateDescriptorSets(device_, &allocInfo, &overlayDescriptorSet_);
-
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = overlayImageView_;
-    imageInfo.sampler = overlaySampler_;
-
-    VkWriteDescriptorSet descriptorWrite = {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = overlayDescriptorSet_;
-    descriptorWrite.dstBinding = 0;
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pImageInfo = &imageInfo;
-
-    vkUpdateDescriptorSets(device_, 1, &descriptorWrite, 0, nullptr);
 }
 
 void Renderer::createFontDescriptor(GfxPipelineData &gfxPipelineData) {
@@ -790,27 +653,10 @@ void Renderer::createFontDescriptor(GfxPipelineData &gfxPipelineData) {
 
 
     vkAllocateDescriptorSets(device_, &allocInfo, &fontDescriptorSet_);
-
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = fontAtlasImageView_;
-    imageInfo.sampler = fontAtlasSampler_;
-
-    VkWriteDescriptorSet descriptorWrite = {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = fontDescriptorSet_;
-    descriptorWrite.dstBinding = 0;
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pImageInfo = &imageInfo;
-
-    vkUpdateDescriptorSets(device_, 1, &descriptorWrite, 0, nullptr);
-
 }
 
 void Renderer::createMainDescriptor(GfxPipelineData &gfxPipelineData) {
-    uint descriptorCount = 5;
+    uint descriptorCount = 1;
     VkDescriptorSetLayoutBinding uboLayoutBinding = {};
     uboLayoutBinding.binding = 0;
     uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -842,20 +688,11 @@ void Renderer::createMainDescriptor(GfxPipelineData &gfxPipelineData) {
     // shipBulletDescriptorSetLayout_,
     //powerUpManager_->doubleShotDescriptorSetLayout};
 
-    VkPushConstantRange mainPC = {};
-    mainPC.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    mainPC.offset = 0;
-    mainPC.size = sizeof(MainPushConstants);
-
-
-    std::vector<VkPushConstantRange> pushConstantRanges = {mainPC};
-
+    // no push constants, per-sprite data comes in as instance attributes (see SpriteInstance)
     VkPipelineLayoutCreateInfo mainPipelineLayoutInfo = {};
     mainPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     mainPipelineLayoutInfo.setLayoutCount = descriptorSetLayouts.size();
     mainPipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    mainPipelineLayoutInfo.pushConstantRangeCount = pushConstantRanges.size();
-    mainPipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 
     createPipelineLayout(mainPipelineLayoutInfo, gfxPipelineData);
     LOGE("main pipelineLayout gd: %llu", gfxPipelineData.pipelineLayout);
@@ -902,8 +739,13 @@ void Renderer::createMainDescriptor(GfxPipelineData &gfxPipelineData) {
     }
 
     shipDescriptorSet_ = descriptorSets[0];
-
     LOGE("Descriptor set created");
+}
+
+// Sets are allocated with their pipeline layouts, but the images and buffers they point at only
+// exist once the assets are loaded, so they get filled in here
+void Renderer::writeDescriptorSets() {
+    uint descriptorCount = 1;
     VkDescriptorBufferInfo bufferInfo = {};
     bufferInfo.buffer = uniformBuffer_;
     bufferInfo.offset = 0;
@@ -918,14 +760,9 @@ void Renderer::createMainDescriptor(GfxPipelineData &gfxPipelineData) {
     bufferDescriptorWrite.descriptorCount = descriptorCount;
     bufferDescriptorWrite.pBufferInfo = &bufferInfo;
 
-    VkDescriptorImageInfo shipImageInfo[5] = {
-            {shipSampler_,       shipImageView_,       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-            {alienSampler_,      alienImageView_,      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-            {shipBulletSampler_, shipBulletImageView_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-            {doubleShotSampler_, doubleShotView_,      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
-            {shieldSampler_,     shieldView_,          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
-    };
-
+    VkDescriptorImageInfo shipImageInfo = {
+            samplerCache_->get(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE),
+            spriteTextures_->view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
 
     VkWriteDescriptorSet samplerDescriptorWrite = {};
     samplerDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -934,12 +771,44 @@ void Renderer::createMainDescriptor(GfxPipelineData &gfxPipelineData) {
     samplerDescriptorWrite.dstArrayElement = 0;
     samplerDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     samplerDescriptorWrite.descriptorCount = descriptorCount;
-    samplerDescriptorWrite.pImageInfo = shipImageInfo;
+    samplerDescriptorWrite.pImageInfo = &shipImageInfo;
 
-    std::vector<VkWriteDescriptorSet> writeDescriptorSets = {samplerDescriptorWrite};
+    std::vector<VkWriteDescriptorSet> mainWrites = {samplerDescriptorWrite};
 
-    vkUpdateDescriptorSets(device_, writeDescriptorSets.size(), writeDescriptorSets.data(), 0,
+    vkUpdateDescriptorSets(device_, mainWrites.size(), mainWrites.data(), 0,
                            nullptr);
+
+    VkDescriptorImageInfo overlayImageInfo = {};
+    overlayImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    overlayImageInfo.imageView = overlayImageView_;
+    overlayImageInfo.sampler = overlaySampler_;
+
+    VkWriteDescriptorSet overlayDescriptorWrite = {};
+    overlayDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    overlayDescriptorWrite.dstSet = overlayDescriptorSet_;
+    overlayDescriptorWrite.dstBinding = 0;
+    overlayDescriptorWrite.dstArrayElement = 0;
+    overlayDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    overlayDescriptorWrite.descriptorCount = 1;
+    overlayDescriptorWrite.pImageInfo = &overlayImageInfo;
+
+    vkUpdateDescriptorSets(device_, 1, &overlayDescriptorWrite, 0, nullptr);
+
+    VkDescriptorImageInfo fontImageInfo = {};
+    fontImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    fontImageInfo.imageView = fontAtlasImageView_;
+    fontImageInfo.sampler = fontAtlasSampler_;
+
+    VkWriteDescriptorSet fontDescriptorWrite = {};
+    fontDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    fontDescriptorWrite.dstSet = fontDescriptorSet_;
+    fontDescriptorWrite.dstBinding = 0;
+    fontDescriptorWrite.dstArrayElement = 0;
+    fontDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    fontDescriptorWrite.descriptorCount = 1;
+    fontDescriptorWrite.pImageInfo = &fontImageInfo;
+
+    vkUpdateDescriptorSets(device_, 1, &fontDescriptorWrite, 0, nullptr);
 }
 
 VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
@@ -984,12 +853,17 @@ void Renderer::createInstance() {
     appInfo.pApplicationName = "3D Space Invaders";
     appInfo.apiVersion = VK_API_VERSION_1_1;
 
-    // Required extensions
-    std::vector<const char *> extensions = {
-            VK_KHR_SURFACE_EXTENSION_NAME,
-            VK_KHR_ANDROID_SURFACE_EXTENSION_NAME,
-            VK_EXT_DEBUG_UTILS_EXTENSION_NAME
-    };
+    // Required extensions (headless doesn't present, so no surface extensions)
+    std::vector<const char *> extensions;
+#ifdef __ANDROID__
+    if (!headless_) {
+        extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_ANDROID_SURFACE_EXTENSION_NAME);
+    }
+#endif
+    if (enableValidationLayers) {
+        extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    }
 
     VkInstanceCreateInfo instanceInfo = {};
     instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -1032,6 +906,7 @@ void Renderer::createInstance() {
 }
 
 void Renderer::createSurface() {
+#ifdef __ANDROID__
     // Create Android surface from ANativeWindow
     VkAndroidSurfaceCreateInfoKHR surfInfo = {};
     surfInfo.sType = VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR;
@@ -1046,6 +921,10 @@ void Renderer::createSurface() {
         LOGE("Failed to create Android Vulkan surface, error code: %d", surfaceResult);
         throw std::runtime_error("Failed to create Android Vulkan surface");
     }
+#else
+    LOGE("No window surface on this platform, use the headless constructor");
+    throw std::runtime_error("No window surface on this platform");
+#endif
 }
 
 void Renderer::getPhysicalDevice() {
@@ -1056,18 +935,20 @@ void Renderer::getPhysicalDevice() {
         LOGE("No Vulkan physical devices found");
         throw std::runtime_error("No Vulkan physical devices found");
     }
-    std::__ndk1::vector<VkPhysicalDevice> devices(deviceCount);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(instance_, &deviceCount, devices.data());
 
 // 2. Pick first device that supports graphics and present
     for (auto d: devices) {
         uint32_t queueFamilyCount = 0;
         vkGetPhysicalDeviceQueueFamilyProperties(d, &queueFamilyCount, nullptr);
-        std::__ndk1::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(d, &queueFamilyCount, queueFamilies.data());
         for (uint32_t i = 0; i < queueFamilyCount; ++i) {
-            VkBool32 presentSupport = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(d, i, surface_, &presentSupport);
+            // nothing gets presented in headless mode
+            VkBool32 presentSupport = headless_ ? VK_TRUE : VK_FALSE;
+            if (!headless_)
+                vkGetPhysicalDeviceSurfaceSupportKHR(d, i, surface_, &presentSupport);
             if ((queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && presentSupport) {
                 physicalDevice_ = d;
                 graphicsQueueFamily_ = i;
@@ -1082,19 +963,52 @@ void Renderer::getPhysicalDevice() {
     }
     LOGE("Physical device and graphics queue family selected: %u", graphicsQueueFamily_);
 
+    // a transfer-only family is usually backed by a DMA engine, uploads can run there without
+    // getting in the way of rendering. Falls back to the graphics queue if there isn't one, or if
+    // its image copies have to be aligned to a coarser granularity than 1x1x1, texture uploads
+    // copy whatever size the texture happens to be
+    transferQueueFamily_ = graphicsQueueFamily_;
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount,
+                                             queueFamilies.data());
+    for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+        VkQueueFlags flags = queueFamilies[i].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) &&
+            !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            VkExtent3D granularity = queueFamilies[i].minImageTransferGranularity;
+            if (granularity.width != 1 || granularity.height != 1 || granularity.depth != 1) {
+                LOGE("Transfer queue family %u needs %ux%ux%u aligned image copies, not using it",
+                     i, granularity.width, granularity.height, granularity.depth);
+                continue;
+            }
+            transferQueueFamily_ = i;
+            LOGE("Dedicated transfer queue family selected: %u", i);
+            break;
+        }
+    }
+    transferImageGranularity_ = queueFamilies[transferQueueFamily_].minImageTransferGranularity;
+
 }
 
 void Renderer::initVulkan() {// Load Vulkan functions using volk
+    TRACE_SCOPE("initVulkan");
     createInstance();
-    createSurface();
+    if (!headless_)
+        createSurface();
     getPhysicalDevice();
 
     float queuePriority = 1.0f;
-    VkDeviceQueueCreateInfo queueCreateInfo = {};
-    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueCreateInfo.queueFamilyIndex = graphicsQueueFamily_;
-    queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriority;
+    VkDeviceQueueCreateInfo queueCreateInfos[2] = {};
+    uint32_t queueCreateInfoCount = transferQueueFamily_ != graphicsQueueFamily_ ? 2 : 1;
+    uint32_t queueFamilies[2] = {graphicsQueueFamily_, transferQueueFamily_};
+    for (uint32_t i = 0; i < queueCreateInfoCount; ++i) {
+        queueCreateInfos[i].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueCreateInfos[i].queueFamilyIndex = queueFamilies[i];
+        queueCreateInfos[i].queueCount = 1;
+        queueCreateInfos[i].pQueuePriorities = &queuePriority;
+    }
 
     const char *deviceExtensions[] = {
             VK_KHR_SWAPCHAIN_EXTENSION_NAME
@@ -1102,9 +1016,9 @@ void Renderer::initVulkan() {// Load Vulkan functions using volk
 
     VkDeviceCreateInfo deviceCreateInfo = {};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.queueCreateInfoCount = 1;
-    deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
-    deviceCreateInfo.enabledExtensionCount = 1;
+    deviceCreateInfo.queueCreateInfoCount = queueCreateInfoCount;
+    deviceCreateInfo.pQueueCreateInfos = queueCreateInfos;
+    deviceCreateInfo.enabledExtensionCount = headless_ ? 0 : 1;
     deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions;
 
     if (vkCreateDevice(physicalDevice_, &deviceCreateInfo, nullptr, &device_) != VK_SUCCESS) {
@@ -1112,14 +1026,87 @@ void Renderer::initVulkan() {// Load Vulkan functions using volk
         throw std::runtime_error("Failed to create Vulkan logical device");
     }
     vkGetDeviceQueue(device_, graphicsQueueFamily_, 0, &graphicsQueue_);
+    vkGetDeviceQueue(device_, transferQueueFamily_, 0, &transferQueue_);
     LOGE("Logical device and graphics queue created");
+    allocator_ = std::make_unique<MemoryAllocator>(device_, physicalDevice_);
+    pipelines_ = std::make_unique<PipelineRegistry>(
+            device_, physicalDevice_,
+            pipelineCacheDir_.empty() ? "" : pipelineCacheDir_ + "/pipeline_cache.bin");
+    uploadContext_ = std::make_unique<UploadContext>(device_, *allocator_, graphicsQueueFamily_,
+                                                     graphicsQueue_, transferQueueFamily_,
+                                                     transferQueue_, transferImageGranularity_);
+
+    if (headless_)
+        createOffscreenTargets();
+    else
+        createSwapchain();
 
-    VkSemaphoreCreateInfo semInfo = {};
-    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    vkCreateSemaphore(device_, &semInfo, nullptr, &imageAvailableSemaphore_);
-    vkCreateSemaphore(device_, &semInfo, nullptr, &renderFinishedSemaphore_);
+    VkAttachmentDescription colorAttachment = {};
+    colorAttachment.format = swapchainFormat_;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    // offscreen targets get copied out (readPixels) rather than presented
+    colorAttachment.finalLayout = headless_ ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                            : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkAttachmentReference colorAttachmentRef = {};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
 
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(device_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS) {
+        LOGE("Failed to create render pass");
+        throw std::runtime_error("Failed to create render pass");
+    }
 
+    framebuffers_.resize(swapchainImageViews_.size());
+    for (size_t i = 0; i < swapchainImageViews_.size(); ++i) {
+        VkImageView attachments[] = {swapchainImageViews_[i]};
+        VkFramebufferCreateInfo fbInfo = {};
+        fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        fbInfo.renderPass = renderPass_;
+        fbInfo.attachmentCount = 1;
+        fbInfo.pAttachments = attachments;
+        fbInfo.width = swapchainExtent_.width;
+        fbInfo.height = swapchainExtent_.height;
+        fbInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device_, &fbInfo, nullptr, &framebuffers_[i]) != VK_SUCCESS) {
+            LOGE("Failed to create framebuffer %d", (int) i);
+            throw std::runtime_error("Failed to create framebuffer");
+        }
+    }
+
+    // Command pool
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = graphicsQueueFamily_;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS) {
+        LOGE("Failed to create command pool");
+        throw std::runtime_error("Failed to create command pool");
+    }
+
+    createFrameResources();
+}
+
+void Renderer::createSwapchain() {
     // 1. Get surface capabilities
     VkSurfaceCapabilitiesKHR surfCaps;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice_, surface_, &surfCaps);
@@ -1127,7 +1114,7 @@ void Renderer::initVulkan() {// Load Vulkan functions using volk
 // 2. Pick a surface format
     uint32_t formatCount = 0;
     vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, surface_, &formatCount, nullptr);
-    std::__ndk1::vector<VkSurfaceFormatKHR> formats(formatCount);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
     vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, surface_, &formatCount, formats.data());
     swapchainFormat_ = formats[0].format; // For most devices, first is fine
 
@@ -1194,106 +1181,76 @@ void Renderer::initVulkan() {// Load Vulkan functions using volk
             throw std::runtime_error("Failed to create image view");
         }
     }
+}
 
-    VkAttachmentDescription colorAttachment = {};
-    colorAttachment.format = swapchainFormat_;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef = {};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-
-    VkRenderPassCreateInfo renderPassInfo = {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-
-    if (vkCreateRenderPass(device_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS) {
-        LOGE("Failed to create render pass");
-        throw std::runtime_error("Failed to create render pass");
-    }
-
-    framebuffers_.resize(swapchainImageViews_.size());
-    for (size_t i = 0; i < swapchainImageViews_.size(); ++i) {
-        VkImageView attachments[] = {swapchainImageViews_[i]};
-        VkFramebufferCreateInfo fbInfo = {};
-        fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        fbInfo.renderPass = renderPass_;
-        fbInfo.attachmentCount = 1;
-        fbInfo.pAttachments = attachments;
-        fbInfo.width = swapchainExtent_.width;
-        fbInfo.height = swapchainExtent_.height;
-        fbInfo.layers = 1;
-
-        if (vkCreateFramebuffer(device_, &fbInfo, nullptr, &framebuffers_[i]) != VK_SUCCESS) {
-            LOGE("Failed to create framebuffer %d", (int) i);
-            throw std::runtime_error("Failed to create framebuffer");
-        }
-    }
-
-    // Command pool
-    VkCommandPoolCreateInfo poolInfo = {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = graphicsQueueFamily_;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS) {
-        LOGE("Failed to create command pool");
-        throw std::runtime_error("Failed to create command pool");
-    }
+void Renderer::createOffscreenTargets() {
+    // one target per frame in flight, so drawFrame can cycle through them like swapchain images
+    swapchainFormat_ = VK_FORMAT_R8G8B8A8_UNORM;
+    swapchainImages_.resize(framesInFlight_);
+    swapchainImageViews_.resize(framesInFlight_);
+    offscreenImageMemory_.resize(framesInFlight_);
+    for (uint32_t i = 0; i < framesInFlight_; ++i) {
+        createImage(device_, *allocator_, swapchainExtent_.width, swapchainExtent_.height,
+                    swapchainFormat_, VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapchainImages_[i],
+                    offscreenImageMemory_[i]);
+        createImageView(device_, swapchainImages_[i], swapchainFormat_, swapchainImageViews_[i]);
+    }
+    LOGE("Offscreen targets created: %u images, extent: %dx%d", framesInFlight_,
+         swapchainExtent_.width, swapchainExtent_.height);
+}
 
-// Command buffers
-    commandBuffers_.resize(framebuffers_.size());
+void Renderer::createFrameResources() {
     VkCommandBufferAllocateInfo allocInfo = {};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.commandPool = commandPool_;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t) commandBuffers_.size();
+    allocInfo.commandBufferCount = 1;
 
-    if (vkAllocateCommandBuffers(device_, &allocInfo, commandBuffers_.data()) != VK_SUCCESS) {
-        LOGE("Failed to allocate command buffers");
-        throw std::runtime_error("Failed to allocate command buffers");
-    }
+    VkSemaphoreCreateInfo semInfo = {};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
+    // created signaled so the first wait on each frame returns straight away
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
+    for (uint32_t i = 0; i < framesInFlight_; ++i) {
+        FrameData &frame = frames_[i];
+        if (vkAllocateCommandBuffers(device_, &allocInfo, &frame.cmd) != VK_SUCCESS) {
+            LOGE("Failed to allocate command buffer for frame %u", i);
+            throw std::runtime_error("Failed to allocate command buffers");
+        }
+        if (vkCreateSemaphore(device_, &semInfo, nullptr, &frame.imageAvailable) != VK_SUCCESS ||
+            vkCreateFence(device_, &fenceInfo, nullptr, &frame.inFlight) != VK_SUCCESS) {
+            LOGE("Failed to create sync objects for frame %u", i);
+            throw std::runtime_error("Failed to create frame sync objects");
+        }
+    }
+    imagesInFlight_.assign(swapchainImages_.size(), VK_NULL_HANDLE);
+    renderFinished_.assign(swapchainImages_.size(), VK_NULL_HANDLE);
+    for (size_t i = 0; i < renderFinished_.size(); ++i) {
+        if (vkCreateSemaphore(device_, &semInfo, nullptr, &renderFinished_[i]) != VK_SUCCESS) {
+            LOGE("Failed to create render finished semaphore for image %zu", i);
+            throw std::runtime_error("Failed to create frame sync objects");
+        }
+    }
+    LOGE("Frames in flight: %u", framesInFlight_);
 }
 
-void updateFontBuffer(VkDevice device, std::vector<Vertex> textVertices,
-                      VkDeviceMemory fontVertexBufferMemory) {
+void updateFontBuffer(const std::vector<Vertex> &textVertices,
+                      const MemoryAllocation &fontVertexBufferMemory) {
     VkDeviceSize textBufferSize = textVertices.size() * sizeof(Vertex);
-    void *fontData;
-    vkMapMemory(device, fontVertexBufferMemory, 0, textBufferSize, 0, &fontData);
-    memcpy(fontData, textVertices.data(), (size_t) textBufferSize);
-    vkUnmapMemory(device, fontVertexBufferMemory);
-}
-
-void uploadDataBuffer(VkDevice device, const void *dataToUpload, VkDeviceSize sizeOfData,
-                      VkDeviceMemory bufferMemory) {
-    void *fontData;
-    vkMapMemory(device, bufferMemory, 0, sizeOfData, 0, &fontData);
-    memcpy(fontData, dataToUpload, (size_t) sizeOfData);
-    vkUnmapMemory(device, bufferMemory);
+    memcpy(fontVertexBufferMemory.mapped, textVertices.data(), (size_t) textBufferSize);
 }
 
 void Renderer::createUniformBuffer() {
     VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-    createBuffer(device_, physicalDevice_, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+    createBuffer(device_, *allocator_, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                  uniformBuffer_, uniformBufferMemory_);
-    vkMapMemory(device_, uniformBufferMemory_, 0, bufferSize, 0, &uniformBuffersData);
+    uniformBuffersData = uniformBufferMemory_.mapped;
 }
 
 void Renderer::updateUniformBuffer() {
@@ -1313,61 +1270,25 @@ void Renderer::updateUniformBuffer() {
 }
 
 void Renderer::initAliens() {
-    float startX = -0.7f;
-    float startY = 0.8f;
-    float dx = 0.2f;
-    float dy = 0.15f;
-    for (int y = 0; y < NUM_ALIENS_Y; ++y) {
-        for (int x = 0; x < NUM_ALIENS_X; ++x) {
-            int idx = y * NUM_ALIENS_X + x;
-            aliens_[idx].x = startX + x * dx;
-            aliens_[idx].y = startY - y * dy;
-            aliens_[idx].active = true;
-            aliens_[idx].hp = 3;
-            aliens_[idx].widthHeight = Util::getQuadWidthHeight(alienVerts, 6, {0.5, 0.5});
-            alienPC_[idx].texturePos = 1;
-        }
+    aliens_.reset();
+    for (auto &sprite: alienSprites_) {
+        sprite.setTexture(spriteTextures_->region(GameTextureType::Alien));
     }
 }
 
 void Renderer::createMainGfxPipeline() {
+    TRACE_SCOPE("createMainGfxPipeline");
 
-    // One binding (per-vertex data)
-    VkVertexInputBindingDescription mainBindingDesc = {};
-    mainBindingDesc.binding = 0;
-    mainBindingDesc.stride = sizeof(Vertex);
-    mainBindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    // binding 0 is the shared sprite quad, binding 1 the per-sprite instance data
+    std::vector<VkVertexInputBindingDescription> bindings = SpriteInstance::getBindingDescriptions();
+    std::vector<VkVertexInputAttributeDescription> attributes = SpriteInstance::getAttributeDescriptions();
 
-// Position (location=0)
-    VkVertexInputAttributeDescription mainPosDesc = {};
-    mainPosDesc.binding = 0;
-    mainPosDesc.location = 0;
-    mainPosDesc.format = VK_FORMAT_R32G32B32_SFLOAT;
-    mainPosDesc.offset = offsetof(Vertex, pos);
-
-// Color (location=1)
-    VkVertexInputAttributeDescription mainColorDesc = {};
-    mainColorDesc.binding = 0;
-    mainColorDesc.location = 1;
-    mainColorDesc.format = VK_FORMAT_R32G32B32_SFLOAT;
-    mainColorDesc.offset = offsetof(Vertex, color);
-
-    // Color (location=1)
-    VkVertexInputAttributeDescription mainUVDesc = {};
-    mainUVDesc.binding = 0;
-    mainUVDesc.location = 2;
-    mainUVDesc.format = VK_FORMAT_R32G32_SFLOAT;
-    mainUVDesc.offset = offsetof(Vertex, uv);
-
-    std::vector<VkVertexInputAttributeDescription> vertexAttributeDesc = {mainPosDesc,
-                                                                          mainColorDesc,
-                                                                          mainUVDesc};
     VkPipelineVertexInputStateCreateInfo mainVertexInputInfo = {};
     mainVertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    mainVertexInputInfo.vertexBindingDescriptionCount = 1;
-    mainVertexInputInfo.pVertexBindingDescriptions = &mainBindingDesc;
-    mainVertexInputInfo.vertexAttributeDescriptionCount = vertexAttributeDesc.size();
-    mainVertexInputInfo.pVertexAttributeDescriptions = vertexAttributeDesc.data();
+    mainVertexInputInfo.vertexBindingDescriptionCount = bindings.size();
+    mainVertexInputInfo.pVertexBindingDescriptions = bindings.data();
+    mainVertexInputInfo.vertexAttributeDescriptionCount = attributes.size();
+    mainVertexInputInfo.pVertexAttributeDescriptions = attributes.data();
 
     GfxPipelineData graphicsPipelineData{
             .pipeline = mainPipeline_,
@@ -1377,7 +1298,7 @@ void Renderer::createMainGfxPipeline() {
             .scissor {.offset{0, 0}, .extent = swapchainExtent_}
     };
 
-    setShaderStages(device_, assetManager_, "main.vert.spv", "main.frag.spv",
+    setShaderStages(*shaderModules_, "main.vert.spv", "main.frag.spv",
                     graphicsPipelineData);
     setColorBlending(graphicsPipelineData);
     setViewPortState(graphicsPipelineData);
@@ -1391,6 +1312,7 @@ void Renderer::createMainGfxPipeline() {
 }
 
 void Renderer::createOverlayGfxPipeline() {
+    TRACE_SCOPE("createOverlayGfxPipeline");
 
     GfxPipelineData graphicsPipelineData{
             .pipeline = overlayPipeline_,
@@ -1398,7 +1320,7 @@ void Renderer::createOverlayGfxPipeline() {
             .scissor {.offset{0, 0}, .extent = swapchainExtent_}
     };
 
-    setShaderStages(device_, assetManager_, "overlay.vert.spv", "overlay.frag.spv",
+    setShaderStages(*shaderModules_, "overlay.vert.spv", "overlay.frag.spv",
                     graphicsPipelineData);
     setColorBlending(graphicsPipelineData);
     setViewPortState(graphicsPipelineData);
@@ -1447,13 +1369,14 @@ void Renderer::createOverlayGfxPipeline() {
 }
 
 void Renderer::createFontGfxPipeline() {
+    TRACE_SCOPE("createFontGfxPipeline");
     GfxPipelineData graphicsPipelineData{
             .pipeline = fontPipeline_,
             .viewport {.x=0.0, .y=0.0f, .width=(float) swapchainExtent_.width, .height=(float) swapchainExtent_.height, .minDepth=0.0f, .maxDepth=1.0f},
             .scissor {.offset{0, 0}, .extent = swapchainExtent_}
     };
 
-    setShaderStages(device_, assetManager_, "font.vert.spv", "font.frag.spv",
+    setShaderStages(*shaderModules_, "font.vert.spv", "font.frag.spv",
                     graphicsPipelineData);
     setColorBlending(graphicsPipelineData);
     setViewPortState(graphicsPipelineData);
@@ -1509,6 +1432,7 @@ void Renderer::createFontGfxPipeline() {
 }
 
 void Renderer::createGfxPipeline(GfxPipelineType gfxPipelineType) {
+    TRACE_SCOPE("createGfxPipeline");
     std::vector<VkVertexInputBindingDescription> bindings;
     std::vector<VkVertexInputAttributeDescription> attributes;
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
@@ -1523,7 +1447,7 @@ void Renderer::createGfxPipeline(GfxPipelineType gfxPipelineType) {
         case GfxPipelineType::AxisAlignedBoundingBoxes:
             graphicsPipelineData.inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
 
-            setShaderStages(device_, assetManager_, "aabb.vert.spv", "aabb.frag.spv",
+            setShaderStages(*shaderModules_, "aabb.vert.spv", "aabb.frag.spv",
                             graphicsPipelineData);
             bindings = Vertex::getBindingDescriptions();
             attributes = Vertex::getAttributeDescriptions();
@@ -1564,6 +1488,7 @@ void Renderer::createGfxPipeline(GfxPipelineType gfxPipelineType) {
 }
 
 void Renderer::createParticlesGfxPipeline(GfxPipelineType gfxPipelineType) {
+    TRACE_SCOPE("createParticlesGfxPipeline");
     std::vector<VkVertexInputBindingDescription> bindings;
     std::vector<VkVertexInputAttributeDescription> attributes;
 
@@ -1573,7 +1498,7 @@ void Renderer::createParticlesGfxPipeline(GfxPipelineType gfxPipelineType) {
     };
 
     if (gfxPipelineType == GfxPipelineType::ExplosionParticles) {
-        setShaderStages(device_, assetManager_, "particles_instanced.vert.spv",
+        setShaderStages(*shaderModules_, "particles_instanced.vert.spv",
                         "particles_instanced.frag.spv",
                         graphicsPipelineData);
 
@@ -1590,8 +1515,26 @@ void Renderer::createParticlesGfxPipeline(GfxPipelineType gfxPipelineType) {
         graphicsPipelineData.vertexInputState = particlesVertexInputInfo;
     }
 
+    if (gfxPipelineType == GfxPipelineType::GpuExplosionParticles) {
+        setShaderStages(*shaderModules_, "particles_instanced.vert.spv",
+                        "particles_instanced.frag.spv",
+                        graphicsPipelineData);
+
+        bindings = GpuParticle::getBindingDescriptions();
+        attributes = GpuParticle::getAttributeDescriptions();
+
+        VkPipelineVertexInputStateCreateInfo particlesVertexInputInfo = {};
+        particlesVertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        particlesVertexInputInfo.vertexBindingDescriptionCount = bindings.size();
+        particlesVertexInputInfo.pVertexBindingDescriptions = bindings.data();
+        particlesVertexInputInfo.vertexAttributeDescriptionCount = attributes.size();
+        particlesVertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+        graphicsPipelineData.vertexInputState = particlesVertexInputInfo;
+    }
+
     if (gfxPipelineType == GfxPipelineType::StarParticles) {
-        setShaderStages(device_, assetManager_, "stars_instanced.vert.spv",
+        setShaderStages(*shaderModules_, "stars_instanced.vert.spv",
                         "stars_instanced.frag.spv",
                         graphicsPipelineData);
 
@@ -1608,8 +1551,27 @@ void Renderer::createParticlesGfxPipeline(GfxPipelineType gfxPipelineType) {
         graphicsPipelineData.vertexInputState = particlesVertexInputInfo;
     }
 
+    if (gfxPipelineType == GfxPipelineType::ProceduralStars) {
+        setShaderStages(*shaderModules_, "stars_procedural.vert.spv",
+                        "stars_instanced.frag.spv",
+                        graphicsPipelineData);
+
+        // only the quad, star positions come from gl_InstanceIndex
+        bindings = {{0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX}};
+        attributes = {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)}};
+
+        VkPipelineVertexInputStateCreateInfo particlesVertexInputInfo = {};
+        particlesVertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        particlesVertexInputInfo.vertexBindingDescriptionCount = bindings.size();
+        particlesVertexInputInfo.pVertexBindingDescriptions = bindings.data();
+        particlesVertexInputInfo.vertexAttributeDescriptionCount = attributes.size();
+        particlesVertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+        graphicsPipelineData.vertexInputState = particlesVertexInputInfo;
+    }
+
     if (gfxPipelineType == GfxPipelineType::HaloEffect) {
-        setShaderStages(device_, assetManager_, "halo.vert.spv",
+        setShaderStages(*shaderModules_, "halo.vert.spv",
                         "halo.frag.spv",
                         graphicsPipelineData);
         bindings = ShieldInstance::getBindingDescriptions();
@@ -1643,7 +1605,8 @@ void Renderer::createParticlesGfxPipeline(GfxPipelineType gfxPipelineType) {
     particlesLayoutInfo.bindingCount = 1;
     particlesLayoutInfo.pBindings = &particleInstanceBinding;
 
-    createDescriptorSetLayout(particlesLayoutInfo, particlesDescriptorSetLayout_);
+    if (particlesDescriptorSetLayout_ == VK_NULL_HANDLE)
+        createDescriptorSetLayout(particlesLayoutInfo, particlesDescriptorSetLayout_);
 
 
     VkPipelineLayoutCreateInfo particlesPipelineLayoutInfo = {};
@@ -1653,6 +1616,15 @@ void Renderer::createParticlesGfxPipeline(GfxPipelineType gfxPipelineType) {
     particlesPipelineLayoutInfo.pushConstantRangeCount = 0;
     particlesPipelineLayoutInfo.pPushConstantRanges = nullptr;
 
+    VkPushConstantRange starFieldPushConstantRange = {};
+    starFieldPushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    starFieldPushConstantRange.offset = 0;
+    starFieldPushConstantRange.size = sizeof(StarFieldPushConstants);
+    if (gfxPipelineType == GfxPipelineType::ProceduralStars) {
+        particlesPipelineLayoutInfo.pushConstantRangeCount = 1;
+        particlesPipelineLayoutInfo.pPushConstantRanges = &starFieldPushConstantRange;
+    }
+
     createPipelineLayout(particlesPipelineLayoutInfo, graphicsPipelineData);
 
 
@@ -1673,14 +1645,18 @@ void setRasterizer(GfxPipelineData &graphicsPipelineData) {
     overlayRasterizer.depthBiasEnable = VK_FALSE;
 }
 
-void setShaderStages(VkDevice device, AAssetManager *assetManager, const char *spirvVertexFilename,
+void setShaderStages(ShaderModuleCache &shaderModules, const char *spirvVertexFilename,
                      const char *spirvFragmentFilename,
                      GfxPipelineData &graphicsPipelineData) {
 
-    auto vertShaderCode = loadShaderAsset(assetManager, spirvVertexFilename);
-    auto fragShaderCode = loadShaderAsset(assetManager, spirvFragmentFilename);
-    VkShaderModule vertShaderModule = createShaderModule(device, vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(device, fragShaderCode);
+    // particle pipelines share shaders, the cache hands back the module that already exists
+    const auto &vertShader = shaderModules.get(spirvVertexFilename);
+    const auto &fragShader = shaderModules.get(spirvFragmentFilename);
+    graphicsPipelineData.shaderHash = PipelineRegistry::hashBytes(&fragShader.hash,
+                                                                  sizeof(fragShader.hash),
+                                                                  vertShader.hash);
+    VkShaderModule vertShaderModule = vertShader.module;
+    VkShaderModule fragShaderModule = fragShader.module;
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -1775,14 +1751,27 @@ Renderer::createPipeline(GfxPipelineData &gfxPipelineData, GfxPipelineType gfxPi
     pipelineCreateInfo.layout = gfxPipelineData.pipelineLayout;
     pipelineCreateInfo.renderPass = renderPass_;
     pipelineCreateInfo.subpass = 0;
-    VkResult res = vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1,
-                                             &pipelineCreateInfo, nullptr,
-                                             &gfxPipelineData.pipeline);
-    if (res != VK_SUCCESS) {
-        LOGE("Failed to create graphics pipeline! error code:%d", res);
-        throw std::runtime_error("Failed to create graphics pipeline");
-    }
+    // identical state comes back as the same pipeline, compiled later by finishPipelines()
+    uint64_t key = pipelines_->enqueue(pipelineCreateInfo, gfxPipelineData.shaderHash);
+    pendingPipelines_.push_back({gfxPipelineType, key, gfxPipelineData.pipelineLayout});
+}
+
+void Renderer::finishPipelines() {
+    TRACE_SCOPE("finishPipelines");
+    pipelines_->waitCompiled();
+    for (const auto &pending: pendingPipelines_) {
+        GfxPipelineData gfxPipelineData{.pipeline = pipelines_->pipeline(pending.key),
+                                        .pipelineLayout = pending.layout};
+        assignPipeline(gfxPipelineData, pending.type);
+    }
+    pendingPipelines_.clear();
+    shaderModules_->clear();
+    // save right away rather than on exit, Android rarely gives us a clean shutdown
+    pipelines_->save();
+}
 
+void
+Renderer::assignPipeline(const GfxPipelineData &gfxPipelineData, GfxPipelineType gfxPipelineType) {
     switch (gfxPipelineType) {
         case GfxPipelineType::Main:
             mainPipeline_ = gfxPipelineData.pipeline;
@@ -1818,13 +1807,17 @@ Renderer::createPipeline(GfxPipelineData &gfxPipelineData, GfxPipelineType gfxPi
         case GfxPipelineType::HaloEffect:
             particleSystem_->haloPipeline = gfxPipelineData.pipeline;
             break;
+        case GfxPipelineType::GpuExplosionParticles:
+            gpuParticlesPipeline_ = gfxPipelineData.pipeline;
+            break;
+        case GfxPipelineType::ProceduralStars:
+            proceduralStarsPipeline_ = gfxPipelineData.pipeline;
+            proceduralStarsPipelineLayout_ = gfxPipelineData.pipelineLayout;
+            break;
         default:
             LOGE("Unknown pipeline name: %s", gfxPipelineType);
             break;
     }
-
-    vkDestroyShaderModule(device_, gfxPipelineData.shaderStages[0].module, nullptr);
-    vkDestroyShaderModule(device_, gfxPipelineData.shaderStages[1].module, nullptr);
 }
 
 void
@@ -1838,12 +1831,63 @@ Renderer::createDescriptorSetLayout(VkDescriptorSetLayoutCreateInfo descriptorSe
     }
 }
 
-void Renderer::recordCommandBuffer(uint32_t imageIndex) {
-    cmd_ = commandBuffers_[imageIndex];
+void Renderer::buildSpriteBatch(SpriteBatch &spriteBatch) {
+    TRACE_SCOPE("buildSpriteBatch");
+    spriteBatch.begin();
+
+    // --- Triangle (or any background)
+    SpriteInstance triangleSprite;
+    triangleSprite.pos = {0.0f, -0.9f};
+    triangleSprite.setTexture(spriteTextures_->region(GameTextureType::Shield));
+    spriteBatch.add(mainPipeline_, shipDescriptorSet_, triangleSprite);
+
+    powerUpManager_->addSprites(spriteBatch, mainPipeline_, shipDescriptorSet_,
+                                *spriteTextures_, shakeOffset);
+
+    // --- Ship
+    // straight from the finger, it's not simulated
+    shipSprite_.pos = {shipX_, shipY_};
+    shipSprite_.shakeOffset = shakeOffset;
+    spriteBatch.add(mainPipeline_, shipDescriptorSet_, shipSprite_);
+
+    // --- Bullets
+    const EntityStore &entities = *entities_;
+    entities.forEach(BULLET_MASK, [&](uint32_t i) {
+        const EntityRender &render = entities.render(i);
+        SpriteInstance bulletSprite;
+        glm::vec2 pos = entities.interpolated(i, Time::alpha);
+        bulletSprite.pos = {pos.x, -pos.y};
+        bulletSprite.shakeOffset = shakeOffset;
+        bulletSprite.setTexture(spriteTextures_->region(render.texture));
+        bulletSprite.scale = render.scale;
+        spriteBatch.add(mainPipeline_, shipDescriptorSet_, bulletSprite);
+    });
+
+    // --- Aliens, drawn with the shared quad so squash it to the alien's width. The formation
+    // only moves while playing, otherwise its last move would keep getting replayed
+    float alienAlpha = gameState == GameState::Playing ? Time::alpha : 1.0f;
+    for (int i = 0; i < MAX_ALIENS; ++i) {
+        if (!aliens_.alive(i)) continue;
+        glm::vec2 pos = aliens_.position(i, alienAlpha);
+        alienSprites_[i].pos = {pos.x, -pos.y};
+        alienSprites_[i].shakeOffset = shakeOffset;
+        alienSprites_[i].scale = {alienVerts[1].pos[0] / quadVerts[1].pos[0], 1.0f};
+        spriteBatch.add(mainPipeline_, shipDescriptorSet_, alienSprites_[i]);
+    }
+}
+
+void Renderer::recordCommandBuffer(uint32_t imageIndex, const FrameSnapshot &snapshot) {
+    TRACE_SCOPE("recordCommandBuffer");
+    FrameData &frame = frames_[currentFrame_];
+    cmd_ = frame.cmd;
 
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     vkBeginCommandBuffer(cmd_, &beginInfo);
+    // this slot's fence was waited on in drawFrame, so last round's timestamps are ready
+    if (perfHud_) perfHud_->beginFrame(cmd_, currentFrame_);
+    // integrate + compact explosion particles, the draw below reads the result indirectly
+    if (gpuParticles_) gpuParticles_->recordSimulation(cmd_, snapshot.deltaTime);
 
     VkClearValue clearColor = {{0.0f, 0.0f, 0.0f, 1.0f}};
     VkRenderPassBeginInfo renderBeginPassInfo = {};
@@ -1857,100 +1901,32 @@ void Renderer::recordCommandBuffer(uint32_t imageIndex) {
 
     vkCmdBeginRenderPass(cmd_, &renderBeginPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-    particleSystem_->recordCommandBuffer(cmd_,
-                                         particlesPipelineLayout_,
-                                         starParticlesPipeline_,
-                                         starVertsBuffer_,
-                                         starIndexBuffer_,
-                                         starInstanceBuffer_,
-                                         GfxPipelineType::StarParticles);
-
-
-    VkDeviceSize offsets[] = {0};
-    // --- Draw triangle (or any background)
-    float trianglePos[2] = {0.0, 0.0};
-    MainPushConstants trianglePC;
-    trianglePC.pos = {0.0f, -0.9f};
-    trianglePC.shakeOffset = {0.0f, 0.0f};
-    trianglePC.flashAmount = 0.0f;
-    trianglePC.texturePos = 4;
-
-    vkCmdBindPipeline(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipeline_);
-    vkCmdPushConstants(cmd_, mainPipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0,
-                       sizeof(MainPushConstants),
-                       &trianglePC);
-    vkCmdBindDescriptorSets(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipelineLayout_, 0, 1,
-                            &shipDescriptorSet_, 0, nullptr);
-    vkCmdBindVertexBuffers(cmd_, 0, 1, &vertexBuffer_, offsets);
-    vkCmdDraw(cmd_, sizeof(quadVerts) / sizeof(Vertex), 1, 0, 0);
-
-
-    powerUpManager_->recordCommandBuffer(cmd_, mainPipelineLayout_, mainPipeline_, shakeOffset,
-                                         shipDescriptorSet_);
-
-    // --- Draw ship
-    float flashAmount = {0.0f};
-
-    shipPC_.pos = {shipX_, ship_.y};
-    shipPC_.shakeOffset = shakeOffset;
-
-    vkCmdBindPipeline(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipeline_);
-    vkCmdBindDescriptorSets(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipelineLayout_, 0, 1,
-                            &shipDescriptorSet_, 0, nullptr);
-    vkCmdPushConstants(cmd_, mainPipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0,
-                       sizeof(MainPushConstants),
-                       &shipPC_);
-
-    vkCmdBindVertexBuffers(cmd_, 0, 1, &shipVertexBuffer_, offsets);
-    vkCmdDraw(cmd_, 6, 1, 0, 0);
-
-
-
-    // --- Draw bullets (for each active bullet, updateExplosionParticles buffer and draw)
-    for (int i = 0; i < MAX_BULLETS; ++i) {
-        if (!bullets_[i].active) continue;
-        bulletPC_[i].pos = {bullets_[i].x, bullets_[i].y};
-        bulletPC_[i].shakeOffset = shakeOffset;
-        bulletPC_[i].texturePos = 2;
-        bulletPC_[i].scale = {0.5f, 0.5f};
-         auto bulletAABB = Collision::getAABB(bullets_[i].x, bullets_[i].y, bullets_[i].widthHeight[0],
-                                              bullets_[i].widthHeight[1]);
-
-        vkCmdBindPipeline(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipeline_);
-        vkCmdBindDescriptorSets(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipelineLayout_, 0, 1,
-                                &shipDescriptorSet_, 0, nullptr);
-        vkCmdPushConstants(cmd_, mainPipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0,
-                           sizeof(MainPushConstants), &bulletPC_[i]);
-        vkCmdBindVertexBuffers(cmd_, 0, 1, &bulletVertexBuffer_, offsets);
-        vkCmdDraw(cmd_, 6, 1, 0, 0);
-        //util_->recordDrawBoundingBox(cmd_, bulletAABB, {0.0f,1.0f,1.0f});
+    if (perfHud_) perfHud_->beginPass(cmd_, GpuPass::Stars);
+    if (particleSystem_->proceduralStars) {
+        particleSystem_->recordStarField(cmd_, proceduralStarsPipelineLayout_,
+                                         proceduralStarsPipeline_, starVertsBuffer_,
+                                         starIndexBuffer_, snapshot.starField);
+    } else {
+        particleSystem_->recordCommandBuffer(cmd_,
+                                             starParticlesPipeline_,
+                                             starVertsBuffer_,
+                                             starIndexBuffer_,
+                                             frame.starInstances,
+                                             snapshot.stars.size());
     }
+    if (perfHud_) perfHud_->endPass(cmd_, GpuPass::Stars);
 
-    for (int i = 0; i < MAX_ALIENS; ++i) {
-        if (!aliens_[i].active) continue;
-        alienPC_[i].pos = {aliens_[i].x, -aliens_[i].y};
-        alienPC_[i].shakeOffset = shakeOffset;
-
-        auto alienAABB = Collision::getAABB(aliens_[i].x, -aliens_[i].y, aliens_[i].widthHeight[0],
-                                            aliens_[i].widthHeight[1]);
 
+    VkDeviceSize offsets[] = {0};
+    // --- Draw every sprite (background icon, power-ups, ship, bullets, aliens) in one go
+    if (perfHud_) perfHud_->beginPass(cmd_, GpuPass::Sprites);
+    snapshot.sprites.recordCommandBuffer(cmd_, vertexBuffer_, frame.spriteInstances);
+    if (perfHud_) perfHud_->endPass(cmd_, GpuPass::Sprites);
 
-        vkCmdBindPipeline(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipeline_);
-        vkCmdBindDescriptorSets(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, mainPipelineLayout_, 0, 1,
-                                &shipDescriptorSet_, 0, nullptr);
-        vkCmdBindVertexBuffers(cmd_, 0, 1, &alienVertexBuffer_, offsets);
-        vkCmdPushConstants(cmd_, mainPipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0,
-                           sizeof(MainPushConstants),
-                           &alienPC_[i]);
-        vkCmdDraw(cmd_, 6, 1, 0, 0);
-//        util_->recordDrawBoundingBox(cmd_, alienAABB, {1.0f,0.0f,0.0f});
-
-    }
-
-    if (gameState != GameState::Playing) {
+    if (snapshot.gameState != GameState::Playing) {
         // Set special color in push constant or UBO (e.g. red for GAME OVER)
         float overlayColor[4];
-        if (gameState == GameState::Lost) {
+        if (snapshot.gameState == GameState::Lost) {
             overlayColor[0] = 1.0f; // Red
             overlayColor[1] = 0.0f;
             overlayColor[2] = 0.0f;
@@ -1972,30 +1948,60 @@ void Renderer::recordCommandBuffer(uint32_t imageIndex) {
     }
 
 
+    if (perfHud_) perfHud_->beginPass(cmd_, GpuPass::Text);
     for (const auto &[textName, textData]: allTextVertices) {
+        // the score changes at runtime so it comes out of the upload ring
+        // only the map's buffers are read here, the game thread rewrites the score's vertices
+        VkBuffer textBuffer = textData.first;
+        VkDeviceSize textOffset = 0;
+        uint32_t vertexCount;
+        if (textName == GameText::Score) {
+            if (!frame.scoreTextVertices.valid()) continue;
+            textBuffer = frame.scoreTextVertices.buffer;
+            textOffset = frame.scoreTextVertices.offset;
+            vertexCount = snapshot.scoreText.size();
+        } else {
+            vertexCount = textData.second.size();
+        }
+        vkCmdBindPipeline(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, fontPipeline_);
+        vkCmdBindDescriptorSets(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, fontPipelineLayout_, 0, 1,
+                                &fontDescriptorSet_, 0, nullptr);
+        vkCmdBindVertexBuffers(cmd_, 0, 1, &textBuffer, &textOffset);
+        vkCmdDraw(cmd_, vertexCount, 1, 0, 0);
+    }
+    if (frame.hudTextVertices.valid()) {
         vkCmdBindPipeline(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, fontPipeline_);
         vkCmdBindDescriptorSets(cmd_, VK_PIPELINE_BIND_POINT_GRAPHICS, fontPipelineLayout_, 0, 1,
                                 &fontDescriptorSet_, 0, nullptr);
-        vkCmdBindVertexBuffers(cmd_, 0, 1, &textData.first, offsets);
-        vkCmdDraw(cmd_, textData.second.size(), 1, 0, 0);
+        vkCmdBindVertexBuffers(cmd_, 0, 1, &frame.hudTextVertices.buffer,
+                               &frame.hudTextVertices.offset);
+        vkCmdDraw(cmd_, perfHud_->textVertexCount(), 1, 0, 0);
     }
+    if (perfHud_) perfHud_->endPass(cmd_, GpuPass::Text);
 
 
-    particleSystem_->recordCommandBuffer(cmd_,
-                                         particlesPipelineLayout_,
-                                         explosionParticlesPipeline_,
-                                         particlesVertexBuffer_,
-                                         particlesIndexBuffer_,
-                                         particlesInstanceBuffer_,
-                                         GfxPipelineType::ExplosionParticles);
+    if (perfHud_) perfHud_->beginPass(cmd_, GpuPass::Particles);
+    if (gpuParticles_) {
+        gpuParticles_->recordDraw(cmd_, gpuParticlesPipeline_, particlesVertexBuffer_,
+                                  particlesIndexBuffer_);
+    } else {
+        particleSystem_->recordCommandBuffer(cmd_,
+                                             explosionParticlesPipeline_,
+                                             particlesVertexBuffer_,
+                                             particlesIndexBuffer_,
+                                             frame.particlesInstances,
+                                             snapshot.particles.size());
+    }
+    if (perfHud_) perfHud_->endPass(cmd_, GpuPass::Particles);
 
+    if (perfHud_) perfHud_->beginPass(cmd_, GpuPass::Halo);
     particleSystem_->recordCommandBuffer(cmd_,
-                                         particlesPipelineLayout_,
-                                         starParticlesPipeline_,
-                                         starInstanceBuffer_,
-                                         starIndexBuffer_,
-                                         starInstanceBuffer_,
-                                         GfxPipelineType::HaloEffect);
+                                         particleSystem_->haloPipeline,
+                                         particleSystem_->haloVertexBuffer,
+                                         particleSystem_->haloIndexBuffer,
+                                         frame.haloInstance,
+                                         snapshot.haloVisible ? 1 : 0);
+    if (perfHud_) perfHud_->endPass(cmd_, GpuPass::Halo);
 
     vkCmdEndRenderPass(cmd_);
     vkEndCommandBuffer(cmd_);
@@ -2003,114 +2009,157 @@ void Renderer::recordCommandBuffer(uint32_t imageIndex) {
 
 void Renderer::restartGame() {
     // Reset player
+    entities_->health(entities_->indexOf(shipEntity_)) = 3;
 
     // Reset aliens
     initAliens();
 
     // Reset bullets
-    for (auto &bullet: bullets_) {
-        bullet.active = false;
-    }
+    entities_->forEach(BULLET_MASK, [this](uint32_t i) { entities_->destroyAt(i); });
 
     // Reset score, level, etc.
     gameState = GameState::Playing;
 }
 
 void Renderer::spawnBullet(BulletType bulletType, glm::vec2 spawnPos) {
+    if (gameState != GameState::Playing) return;
+    // spawnPos is in screen space (y down), entities are in alien space
+    if (bulletType == BulletType::Ship) {
+        if (!canFire) return;
+        // Left and right bullet with double shot, otherwise a normal shot from the center
+        int shots = powerUpManager_->doubleShotActive ? 2 : 1;
+        for (int shot = 0; shot < shots; ++shot) {
+            float offsetX = shots == 1 ? 0.0f : (shot == 0 ? -0.05f : 0.05f);
+            addBullet(*entities_, EntityType::ShipBullet,
+                      {spawnPos.x + offsetX, -(spawnPos.y - 0.04f)}, bulletMoveSpeed_);
+            sfxMixer.playSFX(shootSFXSample.data(), shootSFXSample.size(), 0.05f);
+        }
+        // one volley per fire window, however many touch events land before the next tick
+        canFire = false;
+    } else {
+        addBullet(*entities_, EntityType::AlienBullet, {spawnPos.x, -(spawnPos.y + 0.04f)},
+                  -0.5f);
+    }
+}
+
+void Renderer::updateShipBuffer() {
+    uint32_t ship = entities_->indexOf(shipEntity_);
+    entities_->position(ship) = {shipX_, -shipY_};
+    entities_->prevPosition(ship) = entities_->position(ship);
+}
+
+void Renderer::updateFireTimer() {
+    if (lastFireTime > rateOfFire) {
+        lastFireTime = 0.0f;
+        canFire = true;
+    } else {
+        lastFireTime += Time::deltaTime;
+        canFire = false;
+    }
+}
 
+void Renderer::simulateTick() {
+    TRACE_SCOPE("simulateTick");
     if (gameState == GameState::Playing) {
-        int spawned = 0;
-        bool doubleShot = powerUpManager_->doubleShotActive;
-        for (int i = 0; i < MAX_BULLETS; ++i) {
-            if (!bullets_[i].active && BulletType::Ship == bulletType && canFire) {
-                bullets_[i].bulletType = bulletType;
-                if (doubleShot && spawned == 0) {
-                    // Left bullet
-                    bullets_[i].x = spawnPos.x - 0.05f;
-                    bullets_[i].y = spawnPos.y - 0.04f;
-                    bullets_[i].active = true;
-                    sfxMixer.playSFX(shootSFXSample.data(), shootSFXSample.size(), 0.05f);
-                    spawned++;
-                } else if (doubleShot && spawned == 1) {
-                    // Right bullet
-                    bullets_[i].x = spawnPos.x + 0.05f;
-                    bullets_[i].y = spawnPos.y - 0.04f;
-                    bullets_[i].active = true;
-                    sfxMixer.playSFX(shootSFXSample.data(), shootSFXSample.size(), 0.05f);
-                    spawned++;
-                    break; // Spawned both bullets
-                } else if (!doubleShot) {
-                    // Normal shot: center
-                    bullets_[i].x = spawnPos.x;
-                    bullets_[i].y = spawnPos.y - 0.04f;
-                    bullets_[i].active = true;
-                    sfxMixer.playSFX(shootSFXSample.data(), shootSFXSample.size(), 0.05f);
-                    break;
-                }
-//                 canFire = false;
-//                 lastFireTime = 0.0f;
-            }
+        simulatePlayingTick();
+    } else {
+        updateEntities();
+        alienFireBullet();
+    }
+    if (checksumTicks_) tickChecksums_.push_back(stateChecksum());
+}
 
-            if (!bullets_[i].active && bulletType == BulletType::Alien) {
-                bullets_[i].x = spawnPos.x;
-                bullets_[i].y = spawnPos.y + 0.04f;
-                bullets_[i].active = true;
-                bullets_[i].bulletType = bulletType;
-                break;
-            }
+void Renderer::simulatePlayingTick() {
+    // Everything touching the entity store is one job, in order: entities step first so the
+    // collision pass sweeps this tick's motion, off-screen power-ups go before it indexes them.
+    // The formation only meets the entities in the collision pass, so it moves alongside
+    tickGraph_.clear();
+    JobGraph::JobId entities = tickGraph_.add("tickEntities", [this] {
+        updateEntities();
+        updateFireTimer();
+        updateShipBuffer();
+        powerUpManager_->updatePowerUpData();
+    });
+    JobGraph::JobId aliens = tickGraph_.add("tickAliens", [this] {
+        PerfHud::CpuScope timer(perfHud_.get(), CpuPhase::UpdateAliens);
+        updateAliens();
+    });
+    tickGraph_.add("tickCollision", [this] {
+        {
+            PerfHud::CpuScope timer(perfHud_.get(), CpuPhase::UpdateCollision);
+            updateCollision();
         }
-    }
+        updateGameState();
+        alienFireBullet();
+    }, {entities, aliens});
+    jobs_->run(tickGraph_);
 }
 
-void Renderer::updateShipBuffer() const {
-    ship_.x = shipX_;
-    ship_.y = shipY_;
-    ship_.color[0] = shipX_;
+void Renderer::setTickChecksums(bool enabled) {
+    checksumTicks_ = enabled;
+    tickChecksums_.clear();
 }
 
-void Renderer::updateBullet() {
-    for (int i = 0; i < MAX_BULLETS; ++i) {
-        if (bullets_[i].active) {
-            if (bullets_[i].bulletType == BulletType::Ship)
-                bullets_[i].y -= bulletMoveSpeed_ * Time::deltaTime; // Move up
-            if (bullets_[i].bulletType == BulletType::Alien)
-                bullets_[i].y += 0.5f * Time::deltaTime;             // Move down
+void Renderer::takeTickChecksums(std::vector<uint32_t> &checksums) {
+    checksums.clear();
+    std::swap(checksums, tickChecksums_);
+}
 
-            if ((bullets_[i].bulletType == BulletType::Ship && bullets_[i].y < -1.0f) ||
-                (bullets_[i].bulletType == BulletType::Alien && bullets_[i].y > 1.0f)) {
-                bullets_[i].active = false; // Off screen
-            }
-        }
-    }
+uint32_t Renderer::stateChecksum() {
+    uint64_t hash = PipelineRegistry::hashBytes(nullptr, 0);
+    auto add = [&hash](const auto &value) {
+        hash = PipelineRegistry::hashBytes(&value, sizeof(value), hash);
+    };
+    EntityStore &entities = *entities_;
+    add(entities.size());
+    for (uint32_t i = 0; i < entities.size(); ++i) {
+        add(entities.type(i));
+        add(entities.position(i));
+        add(entities.velocity(i));
+        add(entities.health(i));
+    }
+    // the formation moves as one, so its origin + who's left covers every alien
+    add(aliens_.position(0));
+    add(aliens_.aliveCount());
+    for (uint32_t i = 0; i < aliens_.size(); ++i) {
+        if (!aliens_.alive(i)) continue;
+        add(i);
+        add(aliens_.alien(i).hp);
+    }
+    add(gameState);
+    add(actualScore);
+    add(shipX_);
+    add(shipY_);
+    add(canFire);
+    add(lastFireTime);
+    add(rateOfFire);
+    add(alienMoveSpeed_);
+    add(alienFireTimer_);
+    add(powerUpManager_->doubleShotActive);
+    add(powerUpManager_->doubleShotTimer);
+    add(powerUpManager_->shieldActive);
+    add(powerUpManager_->shieldTimer);
+    return uint32_t(hash ^ (hash >> 32));
+}
 
+void Renderer::updateEntities() {
+    entities_->integrate(Time::deltaTime);
+    // Off screen
+    entities_->forEach(BULLET_MASK, [this](uint32_t i) {
+        float y = entities_->position(i).y;
+        bool up = entities_->type(i) == EntityType::ShipBullet;
+        if (up ? y > 1.0f : y < -1.0f) entities_->destroyAt(i);
+    });
 }
 
 void Renderer::updateAliens() {
-    bool hitEdge = false;
+    // one origin update for the whole wave, edges come from the live column masks
+    aliens_.update(alienMoveSpeed_, Time::deltaTime);
 
-    for (int i = 0; i < MAX_ALIENS; ++i) {
-        if (!aliens_[i].active) continue;
-        // update flash amount (fade in/out) smoothly
-        alienPC_[i].flashAmount -= Time::deltaTime * 5.0f; // fade speed (0.2s)
-        if (alienPC_[i].flashAmount < 0.0f) alienPC_[i].flashAmount = 0.0f;
-
-        // Clamp X position just inside the edge
-        if (aliens_[i].x > 0.85f) aliens_[i].x = 0.85f;
-        if (aliens_[i].x < -0.85f) aliens_[i].x = -0.85f;
-
-        aliens_[i].x += alienMoveSpeed_ * alienDirection_ * Time::deltaTime;
-
-        // Check if any alien hits the left or right edge
-        if (aliens_[i].x > 0.85f || aliens_[i].x < -0.85f)
-            hitEdge = true;
-    }
-    if (hitEdge) {
-        alienDirection_ *= -1;
-        // Move all aliens down a bit
-        for (auto &alien: aliens_) {
-            if (alien.active)
-                alien.y -= 0.04f;
-        }
+    // update flash amount (fade in/out) smoothly, sprite state only
+    for (auto &sprite: alienSprites_) {
+        sprite.flashAmount -= Time::deltaTime * 5.0f; // fade speed (0.2s)
+        if (sprite.flashAmount < 0.0f) sprite.flashAmount = 0.0f;
     }
 }
 
@@ -2118,56 +2167,81 @@ void Renderer::updateAliens() {
 uint x = 0;
 
 void Renderer::updateCollision() {
-    for (auto &bullet: bullets_) {
-        if (!bullet.active) continue;
-
-        for (int i = 0; i < MAX_ALIENS; i++) {
-            if (!aliens_[i].active) continue;
-
-            if (isCollision(aliens_[i], bullet) && bullet.bulletType == BulletType::Ship) {
-                bullet.active = false;   // Destroy bullet
-                aliens_[i].hp--;
-                // On hit:
-                alienPC_[i].flashAmount = 1.0f;
-
-                if (aliens_[i].hp <= 0) {
-                    aliens_[i].active = false;    // Destroy alien
-                    actualScore += 100;
-                    alienMoveSpeed_ += 0.005f;
-                    rateOfFire -= 0.0005f;
-                    particleSystem_->spawn(glm::vec3(aliens_[i].x, -aliens_[i].y, 1.0f), 15);
+    TRACE_SCOPE("updateCollision");
+    // Everything is swept over the last step so fast bullets can't tunnel at big time steps.
+    // Ship bullets ask the formation directly, it knows which grid cells a box can touch, and
+    // hit whichever alien they reach first
+    EntityStore &entities = *entities_;
+    entities.forEach(entityMask(EntityType::ShipBullet), [&](uint32_t i) {
+        float timeOfImpact;
+        int hit = aliens_.sweepTest(entities.startBounds(i), entities.step(i), timeOfImpact);
+        if (hit < 0) return;
+
+        Alien &alien = aliens_.alien(hit);
+        entities.destroyAt(i);   // Destroy bullet
+        alien.hp--;
+        // On hit:
+        alienSprites_[hit].flashAmount = 1.0f;
+
+        if (alien.hp <= 0) {
+            glm::vec2 pos = aliens_.position(hit);
+            aliens_.kill(hit);    // Destroy alien
+            actualScore += 100;
+            alienMoveSpeed_ += 0.005f;
+            rateOfFire -= 0.0005f;
+            particleSystem_->spawn(glm::vec3(pos.x, -pos.y, 1.0f), 15);
 //                    sfxMixer.playSFX(explosionSFXMap[x].data(), explosionSFXMap[x].scale(), 0.3f);
-                    powerUpManager_->spawnPowerUp(PowerUpType::DoubleShot,
-                                                  {aliens_[i].x, aliens_[i].y});
-                    x++;
-                    x == explosionSFXMap.size() ? x = 0 : x;
-                    shakeTimer = 0.2f;
-                }
-                break; // Stop checking this bullet (it's now gone)
-            }
+            powerUpManager_->spawnPowerUp(PowerUpType::DoubleShot, pos);
+            x++;
+            x == explosionSFXMap.size() ? x = 0 : x;
+            shakeTimer = 0.2f;
+        }
+    });
+
+    // user ids are dense entity indices, hits only destroyLater() so they hold for the whole
+    // pair loop
+    uint32_t ship = entities.indexOf(shipEntity_);
+    AABB shipBox = entities.bounds(ship);
+    broadphase_.clear();
+    broadphase_.add(shipBox, LayerShip, LayerPowerUp, ship);
+    uint32_t shipTargets = entityMask(EntityType::AlienBullet) | PowerUpManager::POWER_UP_MASK;
+    entities.forEach(shipTargets, [&](uint32_t i) {
+        // only the ship asks for power-ups, so their pairs always come out ship first
+        bool bullet = entities.type(i) == EntityType::AlienBullet;
+        glm::vec2 step = entities.step(i);
+        broadphase_.add(Collision::sweptBounds(entities.startBounds(i), step.x, step.y),
+                        bullet ? LayerAlienBullet : LayerPowerUp, bullet ? LayerShip : 0, i);
+    });
+
+    for (const CollisionPair &pair: broadphase_.findPairs()) {
+        if (pair.firstLayer == LayerAlienBullet) {
+            glm::vec2 step = entities.step(pair.first);
+            float timeOfImpact;
+            if (!Collision::sweep(entities.startBounds(pair.first), step.x, step.y, shipBox,
+                                  timeOfImpact))
+                continue;
+            entities.destroyLater(pair.first);
+            // the shield soaks it up, otherwise it costs a life
+            if (powerUpManager_->shieldActive) continue;
+            shakeTimer = 0.2f;
+            int &hp = entities.health(ship);
+            if (hp > 0 && --hp == 0) gameState = GameState::Lost;
+        } else if (pair.firstLayer == LayerShip) {
+            powerUpManager_->collect(pair.second, shipBox);
         }
     }
+    entities.flushDestroyed();
 }
 
 void Renderer::updateGameState() {
     if (gameState == GameState::Playing) {
         // --- Game Over: Any alien reaches the bottom (e.g. y < -0.9f)
-        for (const auto &alien: aliens_) {
-            if (alien.active && alien.y < -0.9f) {
-                gameState = GameState::Lost;
-                // Optionally: Play sound, trigger animation, etc.
-                break;
-            }
+        if (aliens_.aliveCount() > 0 && aliens_.lowestY() < -0.9f) {
+            gameState = GameState::Lost;
+            // Optionally: Play sound, trigger animation, etc.
         }
 
-        bool anyAlienAlive = false;
-        for (const auto &alien: aliens_) {
-            if (alien.active) {
-                anyAlienAlive = true;
-                break;
-            }
-        }
-        if (!anyAlienAlive) {
+        if (aliens_.aliveCount() == 0) {
             gameState = GameState::Won;
             // Optionally: Play win sound, trigger animation, etc.
         }
@@ -2209,8 +2283,7 @@ void Renderer::animateScore() {
         std::vector<Vertex> scoreVertices;
         scoreVertices = fontManager_->buildTextVertices(scoreText_, -0.95f, -0.80f, 1.0f,
                                                         scoreScale_);
-        allTextVertices[GameText::Score] = {scoreTextVertexBuffer_, scoreVertices};
-        updateFontBuffer(device_, scoreVertices, scoreTextVertexBufferMemory_);
+        allTextVertices[GameText::Score].second = scoreVertices;
 
         // POP! Trigger the scale effect
         scoreScale_ = scorePopAmount_;
@@ -2233,76 +2306,328 @@ void Renderer::animateScore() {
         std::vector<Vertex> scoreVertices;
         scoreVertices = fontManager_->buildTextVertices(scoreText_, -0.95f, -0.80f, 1.0f,
                                                         scoreScale_);
-        allTextVertices[GameText::Score] = {scoreTextVertexBuffer_, scoreVertices};
-        updateFontBuffer(device_, scoreVertices, scoreTextVertexBufferMemory_);
+        allTextVertices[GameText::Score].second = scoreVertices;
     }
 }
 
 
 void Renderer::drawFrame() {
+    simulateFrame(snapshots_.writeSlot());
+    if (!renderThread_.joinable()) {
+        snapshots_.publish();
+        snapshots_.acquire();
+        renderFrame(snapshots_.readSlot());
+        return;
+    }
+    {
+        TRACE_SCOPE("waitRenderThread");
+        std::unique_lock<std::mutex> lock(renderMutex_);
+        // at most one snapshot waiting, so the game runs at the render thread's pace and every
+        // snapshot gets recorded (their GPU particle emits would be lost otherwise)
+        renderWake_.wait(lock, [this] { return !snapshots_.hasFresh(); });
+        snapshots_.publish();
+    }
+    renderWake_.notify_all();
+}
 
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, imageAvailableSemaphore_, VK_NULL_HANDLE,
-                          &imageIndex);
-    if (gameState == GameState::Playing) {
-        if (lastFireTime > rateOfFire) {
-            lastFireTime = 0.0f;
-            canFire = true;
-        } else {
-            lastFireTime += Time::deltaTime;
-            canFire = false;
+void Renderer::simulateFrame(FrameSnapshot &snapshot) {
+    TRACE_SCOPE("simulateFrame");
+    {
+        TRACE_SCOPE("update");
+        // as many fixed ticks as the frame's time pays for, none on some high refresh frames.
+        // Drawing interpolates between the last two
+        while (Time::beginTick()) {
+            simulateTick();
         }
-        updateUniformBuffer();
-        updateShipBuffer();
-
-        updateAliens();
-        updateCollision();
-        powerUpManager_->updatePowerUpData();
-        powerUpManager_->checkIfPowerUpCollected(ship_);
-        animateScore();
-        updateGameState();
     }
+    // The ticks are done with the game state, from here on every job only reads it and fills in
+    // its own part of the snapshot (or of the particle system), so they can all run at once
+    frameGraph_.clear();
+    frameGraph_.add("score", [this, &snapshot] {
+        if (gameState == GameState::Playing) {
+            updateUniformBuffer();
+            PerfHud::CpuScope timer(perfHud_.get(), CpuPhase::AnimateScore);
+            animateScore();
+        }
+        snapshot.scoreText = allTextVertices[GameText::Score].second;
+    });
+    frameGraph_.add("halo", [this, &snapshot] {
+        glm::vec2 shipPos = entities_->position(entities_->indexOf(shipEntity_));
+        snapshot.haloVisible = particleSystem_->updateHaloEffect({shipPos.x, -shipPos.y},
+                                                                 shipHaloSize_, snapshot.halo);
+    });
+    frameGraph_.add("starField", [this, &snapshot] {
+        PerfHud::CpuScope timer(perfHud_.get(), CpuPhase::UpdateStarField);
+        particleSystem_->updateStarField(snapshot.stars, snapshot.starField);
+    });
+    frameGraph_.add("explosionParticles", [this, &snapshot] {
+        PerfHud::CpuScope timer(perfHud_.get(), CpuPhase::UpdateExplosionParticles);
+        particleSystem_->updateExplosionParticles(snapshot.particles);
+        particleSystem_->takeGpuEmits(snapshot.gpuEmits);
+    });
+    frameGraph_.add("sprites", [this, &snapshot] {
+        // Each frame:
+        shakeOffset = {0.0f, 0.0f};
+        if (shakeTimer > 0.0f) {
+            std::uniform_real_distribution<float> shake(-shakeMagnitude, shakeMagnitude);
+            shakeOffset.x = shake(shakeRng_);
+            shakeOffset.y = shake(shakeRng_);
+            shakeTimer -= Time::deltaTime;
+        }
+        buildSpriteBatch(snapshot.sprites);
+    });
+    jobs_->run(frameGraph_);
+    snapshot.gameState = gameState;
+    snapshot.deltaTime = Time::deltaTime;
+}
 
-    updateBullet();
-    alienFireBullet();
-    particleSystem_->updateHaloEffect(ship_);
-    particleSystem_->updateStarField(starInstanceBufferMemory_);
-    particleSystem_->updateExplosionParticles(particlesInstanceBufferMemory_);
-
-// Each frame:
-    shakeOffset = {0.0f, 0.0f};
-    if (shakeTimer > 0.0f) {
-        shakeOffset.x = (rand() / (float) RAND_MAX - 0.5f) * 2.0f * shakeMagnitude;
-        shakeOffset.y = (rand() / (float) RAND_MAX - 0.5f) * 2.0f * shakeMagnitude;
-        shakeTimer -= Time::deltaTime;
+void Renderer::renderFrame(const FrameSnapshot &snapshot) {
+    using Clock = std::chrono::steady_clock;
+    auto frameStart = Clock::now();
+    TRACE_SCOPE("renderFrame");
+    FrameData &frame = frames_[currentFrame_];
+
+    uint32_t imageIndex = currentFrame_; // headless: one offscreen target per frame
+    {
+        TRACE_SCOPE("acquire");
+        // only block on the frame we're about to reuse, the others keep the GPU busy
+        vkWaitForFences(device_, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+        if (!headless_) {
+            vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, frame.imageAvailable,
+                                  VK_NULL_HANDLE, &imageIndex);
+        }
+    }
+    // the swapchain can hand images back out of order, so make sure no other frame still owns it
+    if (imagesInFlight_[imageIndex] != VK_NULL_HANDLE &&
+        imagesInFlight_[imageIndex] != frame.inFlight) {
+        vkWaitForFences(device_, 1, &imagesInFlight_[imageIndex], VK_TRUE, UINT64_MAX);
+    }
+    imagesInFlight_[imageIndex] = frame.inFlight;
+    // the GPU is done with this frame's slice now, start bump allocating from the top of it
+    uploadRing_->beginFrame(currentFrame_);
+    // hand startup staging memory back once the upload batch has landed
+    if (uploadContext_->pendingBatches())
+        uploadContext_->poll();
+    double fenceWaitMs = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+
+    {
+        TRACE_SCOPE("upload");
+        // instances go straight into the mapped ring, no staging copy
+        frame.particlesInstances = uploadRing_->push(
+                snapshot.particles.data(), snapshot.particles.size() * sizeof(ParticleInstance));
+        frame.starInstances = uploadRing_->push(snapshot.stars.data(),
+                                                snapshot.stars.size() * sizeof(StarInstance));
+        frame.haloInstance = snapshot.haloVisible
+                             ? uploadRing_->push(&snapshot.halo, sizeof(ShieldInstance))
+                             : UploadRing::Allocation{};
+        frame.scoreTextVertices = uploadRing_->push(snapshot.scoreText.data(),
+                                                    snapshot.scoreText.size() * sizeof(Vertex));
+        frame.spriteInstances = snapshot.sprites.upload(*uploadRing_);
+        frame.hudTextVertices = perfHud_ ? perfHud_->uploadText(*fontManager_, *uploadRing_)
+                                         : UploadRing::Allocation{};
+        if (gpuParticles_) {
+            for (const ParticleEmit &emit: snapshot.gpuEmits)
+                gpuParticles_->emit(emit.position, emit.count);
+        }
     }
 
-
-    recordCommandBuffer(imageIndex);
+    auto recordStart = Clock::now();
+    {
+        PerfHud::CpuScope timer(perfHud_.get(), CpuPhase::RecordCommandBuffer);
+        recordCommandBuffer(imageIndex, snapshot);
+    }
+    double recordMs = std::chrono::duration<double, std::milli>(Clock::now() - recordStart).count();
 
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &imageAvailableSemaphore_;
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.pWaitDstStageMask = waitStages;
+    if (!headless_) {
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &frame.imageAvailable;
+        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &renderFinished_[imageIndex];
+    }
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers_[imageIndex];
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &renderFinishedSemaphore_;
+    submitInfo.pCommandBuffers = &frame.cmd;
 
-    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
+    {
+        TRACE_SCOPE("submit");
+        vkResetFences(device_, 1, &frame.inFlight);
+        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, frame.inFlight);
+    }
+    lastRenderedImage_ = static_cast<int32_t>(imageIndex);
+
+    if (headless_) {
+        finishFrame(frameStart, fenceWaitMs, recordMs);
+        return;
+    }
 
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &renderFinishedSemaphore_;
+    presentInfo.pWaitSemaphores = &renderFinished_[imageIndex];
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &swapchain_;
     presentInfo.pImageIndices = &imageIndex;
 
-    vkQueuePresentKHR(graphicsQueue_, &presentInfo);
+    {
+        TRACE_SCOPE("present");
+        vkQueuePresentKHR(graphicsQueue_, &presentInfo);
+    }
+    finishFrame(frameStart, fenceWaitMs, recordMs);
+}
+
+void Renderer::startRenderThread() {
+    if (renderThread_.joinable()) return;
+    renderThreadStopping_ = false;
+    renderThread_ = std::thread(&Renderer::renderLoop, this);
+}
+
+void Renderer::startJobSystem(uint32_t workerCount, bool pinWorkers) {
+    // the old workers are idle between frames, destroying it just joins them
+    jobs_ = std::make_unique<JobSystem>(workerCount, pinWorkers);
+    particleSystem_->setJobSystem(jobs_.get());
+}
+
+void Renderer::stopRenderThread() {
+    if (!renderThread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(renderMutex_);
+        renderThreadStopping_ = true;
+    }
+    renderWake_.notify_all();
+    renderThread_.join();
+}
+
+void Renderer::renderLoop() {
+    Trace::setThreadName("render");
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(renderMutex_);
+            renderWake_.wait(lock, [this] {
+                return snapshots_.hasFresh() || renderThreadStopping_;
+            });
+            // a snapshot handed over before stop still gets drawn
+            if (!snapshots_.acquire()) return;
+        }
+        // the game thread can publish the next one now
+        renderWake_.notify_all();
+        renderFrame(snapshots_.readSlot());
+    }
+}
+
+void Renderer::enablePerfHud() {
+    if (!perfHud_) {
+        perfHud_ = std::make_unique<PerfHud>(device_, physicalDevice_, graphicsQueueFamily_,
+                                             framesInFlight_);
+    }
+}
+
+void Renderer::finishFrame(std::chrono::steady_clock::time_point frameStart, double fenceWaitMs,
+                           double recordMs) {
+    // single frame mode keeps the old fully serialised behaviour, handy for comparing timings
+    if (framesInFlight_ == 1) {
+        vkQueueWaitIdle(graphicsQueue_);
+    }
+    currentFrame_ = (currentFrame_ + 1) % framesInFlight_;
+
+    if (lastFrameStart_ != std::chrono::steady_clock::time_point{}) {
+        double frameMs = std::chrono::duration<double, std::milli>(
+                frameStart - lastFrameStart_).count();
+        logFrameTiming(frameMs, fenceWaitMs, recordMs);
+        if (perfHud_) perfHud_->addFrameTime(static_cast<float>(frameMs));
+    }
+    lastFrameStart_ = frameStart;
+
+    // startup plus the first few seconds of play, then stop recording so the buffers stay small
+    if (!traceFile_.empty() && ++tracedFrames_ == TRACE_CAPTURE_FRAMES) {
+        Trace::writeJson(traceFile_);
+        Trace::setEnabled(false);
+        traceFile_.clear();
+    }
+}
+
+void Renderer::logFrameTiming(double frameMs, double fenceWaitMs, double recordMs) {
+    frameTimeAccumMs_ += frameMs;
+    fenceWaitAccumMs_ += fenceWaitMs;
+    recordAccumMs_ += recordMs;
+    if (++frameTimeSamples_ < FRAME_TIMING_LOG_INTERVAL) return;
+
+    LOGE("Frame timing (%u in flight): avg frame %.2f ms, avg fence wait %.2f ms, avg record %.3f ms",
+         framesInFlight_, frameTimeAccumMs_ / frameTimeSamples_,
+         fenceWaitAccumMs_ / frameTimeSamples_, recordAccumMs_ / frameTimeSamples_);
+    frameTimeAccumMs_ = 0.0;
+    fenceWaitAccumMs_ = 0.0;
+    recordAccumMs_ = 0.0;
+    frameTimeSamples_ = 0;
+}
+
+bool Renderer::readPixels(std::vector<uint8_t> &rgba, uint32_t &width, uint32_t &height) {
+    if (!headless_ || lastRenderedImage_ < 0) {
+        LOGE("readPixels needs a headless renderer with at least one frame drawn");
+        return false;
+    }
+    vkDeviceWaitIdle(device_);
+
+    width = swapchainExtent_.width;
+    height = swapchainExtent_.height;
+    VkDeviceSize size = VkDeviceSize(width) * height * 4;
+
+    VkBuffer readbackBuffer{VK_NULL_HANDLE};
+    MemoryAllocation readbackMemory;
+    createBuffer(device_, *allocator_, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 readbackBuffer, readbackMemory);
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool_;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    // the render pass already left the target in TRANSFER_SRC_OPTIMAL
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {width, height, 1};
+    vkCmdCopyImageToBuffer(commandBuffer, swapchainImages_[lastRenderedImage_],
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readbackBuffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
     vkQueueWaitIdle(graphicsQueue_);
+    vkFreeCommandBuffers(device_, commandPool_, 1, &commandBuffer);
+
+    rgba.resize(size);
+    memcpy(rgba.data(), readbackMemory.mapped, size);
+
+    vkDestroyBuffer(device_, readbackBuffer, nullptr);
+    allocator_->free(readbackMemory);
+    return true;
 }
 
 
@@ -2312,83 +2637,55 @@ void Renderer::loadText() {
                                                     0.0f, 0.002f);
 
     VkDeviceSize titleTextBufferSize = titleVertices.size() * sizeof(Vertex);
-    createBuffer(device_, physicalDevice_,
+    createBuffer(device_, *allocator_,
                  titleTextBufferSize,
                  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                  titleTextVertexBuffer_, titleTextVertexBufferMemory_);
-    updateFontBuffer(device_, titleVertices, titleTextVertexBufferMemory_);
+    updateFontBuffer(titleVertices, titleTextVertexBufferMemory_);
     allTextVertices[GameText::Title] = {titleTextVertexBuffer_, titleVertices};
 
+    // the score changes at runtime, it's pushed through the upload ring every frame
     std::vector<Vertex> scoreVertices;
-    scoreVertices = fontManager_->buildTextVertices("Score:99999999", -0.95f, -0.8f, 0.0f, 0.002f);
-    VkDeviceSize scoreTextBufferSize = scoreVertices.size() * sizeof(Vertex);
-    createBuffer(device_, physicalDevice_,
-                 scoreTextBufferSize,
-                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 scoreTextVertexBuffer_, scoreTextVertexBufferMemory_);
     scoreVertices = fontManager_->buildTextVertices("Score:0", -0.95f, -0.8f, 0.0f, 0.002f);
-    allTextVertices[GameText::Score] = {scoreTextVertexBuffer_, scoreVertices};
-    updateFontBuffer(device_, scoreVertices, scoreTextVertexBufferMemory_);
+    allTextVertices[GameText::Score] = {VK_NULL_HANDLE, scoreVertices};
 
 
 }
 
 void Renderer::createAndUploadBuffer(const void *vertices, VkBuffer &buffer,
-                                     VkDeviceMemory &bufferMemory, VkDeviceSize size,
+                                     MemoryAllocation &bufferMemory, VkDeviceSize size,
                                      VkBufferUsageFlags usage) {
-    createBuffer(device_, physicalDevice_, size, usage,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 buffer, bufferMemory);
-    uploadDataBuffer(device_, vertices, size,
-                     bufferMemory);
+    // static data, so keep it device local and let the upload batch copy it over
+    createBuffer(device_, *allocator_, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+    UploadContext::Staging staging = uploadContext_->allocateStaging(size);
+    memcpy(staging.data, vertices, size);
+    uploadContext_->uploadBuffer(buffer, staging);
 }
 
 void Renderer::loadGameObjects() {
-    createAndUploadBuffer(quadVerts, util_->vtxBuffer, util_->stagingBufferMemory,
-                          sizeof(quadVerts), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-
-    createAndUploadBuffer(quadVerts, powerUpManager_->powerUpBuffer,
-                          powerUpManager_->powerUpBufferMemory, sizeof(quadVerts),
-                          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-
     createAndUploadBuffer(starVerts, starVertsBuffer_, starVertsMemory_, sizeof(starVerts),
                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
     createAndUploadBuffer(particlesIndices, starIndexBuffer_, starIndexMemory_,
                           sizeof(particlesIndices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
-    createAndUploadBuffer(starVerts, starInstanceBuffer_, starInstanceBufferMemory_,
-                          sizeof(StarInstance) * NUM_STARS,
-                          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
 
     createAndUploadBuffer(particleVerts, particlesVertexBuffer_, particlesVertexBufferMemory_,
                           sizeof(particleVerts), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
     createAndUploadBuffer(particlesIndices, particlesIndexBuffer_, particlesIndexBufferMemory_,
                           sizeof(particlesIndices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
-    createAndUploadBuffer(particleVerts, particlesInstanceBuffer_, particlesInstanceBufferMemory_,
-                          sizeof(ParticleInstance) * MAX_PARTICLES,
-                          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
 
-    createAndUploadBuffer(quadVerts, bulletVertexBuffer_, bulletVertexBufferMemory_,
-                          sizeof(quadVerts), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-
-    for (auto &bullet: bullets_) {
-        bullet.active = false;
-        bullet.widthHeight = Util::getQuadWidthHeight(quadVerts, 6, {0.2, 0.5});
-    }
+    uint32_t ship = entities_->create(EntityType::Ship, {shipX_, -shipY_}, {0.0f, 0.0f},
+                                      {shipSize_[0], shipSize_[1]}, 3);
+    entities_->render(ship).texture = GameTextureType::Ship;
+    shipEntity_ = entities_->handle(ship);
 
+    // every main pipeline sprite is this quad, scaled/offset per instance
     createAndUploadBuffer(quadVerts, vertexBuffer_, vertexBufferMemory_, sizeof(quadVerts),
                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 
-
-    createAndUploadBuffer(shipVerts, shipVertexBuffer_, shipVertexBufferMemory_, sizeof(shipVerts),
-                          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-
-    createAndUploadBuffer(alienVerts, alienVertexBuffer_, alienVertexBufferMemory_,
-                          sizeof(alienVerts), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-
     createAndUploadBuffer(overlayQuadVerts, overlayVertexBuffer_, overlayVertexBufferMemory_,
                           sizeof(overlayQuadVerts), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 
@@ -2398,97 +2695,84 @@ void Renderer::loadGameObjects() {
     createAndUploadBuffer(particlesIndices, particleSystem_->haloIndexBuffer,
                           particleSystem_->haloIndexBufferMemory, sizeof(particlesIndices),
                           VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
-    createAndUploadBuffer(particleVerts, particleSystem_->haloInstanceBuffer,
-                          particleSystem_->haloInstanceBufferMemory, sizeof(ShieldInstance) * 6,
-                          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+}
 
+void Renderer::createUploadRing() {
+    // offsets handed out get used for vertex and storage bindings, so honour the strictest limit
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+    VkDeviceSize alignment = std::max<VkDeviceSize>(
+            {16, properties.limits.minStorageBufferOffsetAlignment,
+             properties.limits.minUniformBufferOffsetAlignment,
+             properties.limits.nonCoherentAtomSize});
+
+    VkBuffer ringBuffer;
+    MemoryAllocation ringMemory;
+    createBuffer(device_, *allocator_, UPLOAD_RING_FRAME_SIZE * framesInFlight_,
+                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 ringBuffer, ringMemory);
+    uploadRing_ = std::make_unique<UploadRing>(device_, *allocator_, ringBuffer, ringMemory,
+                                               UPLOAD_RING_FRAME_SIZE, framesInFlight_,
+                                               alignment);
 }
 
 Renderer::~Renderer() {
+    stopRenderThread();
+    // frames may still be in flight
+    if (device_ != VK_NULL_HANDLE)
+        vkDeviceWaitIdle(device_);
 
-    vkDestroySampler(device_, fontAtlasSampler_, nullptr);
     vkDestroyImageView(device_, fontAtlasImageView_, nullptr);
-    vkFreeMemory(device_, fontAtlasImageDeviceMemory_, nullptr);
+    allocator_->free(fontAtlasImageDeviceMemory_);
     vkDestroyImage(device_, fontAtlasImage_, nullptr);
 
-
-    vkDestroySampler(device_, shipSampler_, nullptr);
-    vkDestroyImageView(device_, shipImageView_, nullptr);
-    vkFreeMemory(device_, shipImageDeviceMemory_, nullptr);
-    vkDestroyImage(device_, shipImage_, nullptr);
-
-    vkDestroySampler(device_, alienSampler_, nullptr);
-    vkDestroyImageView(device_, alienImageView_, nullptr);
-    vkFreeMemory(device_, alienImageDeviceMemory_, nullptr);
-    vkDestroyImage(device_, alienImage_, nullptr);
-
-    vkDestroySampler(device_, shipBulletSampler_, nullptr);
-    vkDestroyImageView(device_, shipBulletImageView_, nullptr);
-    vkFreeMemory(device_, shipBulletImageDeviceMemory_, nullptr);
-    vkDestroyImage(device_, shipBulletImage_, nullptr);
-
     vkDestroyImageView(device_, overlayImageView_, nullptr);
-    vkDestroySampler(device_, overlaySampler_, nullptr);
-    vkFreeMemory(device_, overlayImageDeviceMemory_, nullptr);
+    allocator_->free(overlayImageDeviceMemory_);
     vkDestroyImage(device_, overlayImage_, nullptr);
 
+    spriteTextures_.reset();
+    samplerCache_.reset();
+
     vkDestroyBuffer(device_, starVertsBuffer_, nullptr);
-    vkFreeMemory(device_, starVertsMemory_, nullptr);
+    allocator_->free(starVertsMemory_);
     vkDestroyBuffer(device_, starIndexBuffer_, nullptr);
-    vkFreeMemory(device_, starIndexMemory_, nullptr);
-    vkDestroyBuffer(device_, starInstanceBuffer_, nullptr);
-    vkFreeMemory(device_, starInstanceBufferMemory_, nullptr);
+    allocator_->free(starIndexMemory_);
 
     vkDestroyBuffer(device_, titleTextVertexBuffer_, nullptr);
-    vkFreeMemory(device_, titleTextVertexBufferMemory_, nullptr);
-
-    vkDestroyBuffer(device_, scoreTextVertexBuffer_, nullptr);
-    vkFreeMemory(device_, scoreTextVertexBufferMemory_, nullptr);
-
-    vkDestroyBuffer(device_, alienVertexBuffer_, nullptr);
-    vkFreeMemory(device_, alienVertexBufferMemory_, nullptr);
-
-    vkDestroyBuffer(device_, bulletVertexBuffer_, nullptr);
-    vkFreeMemory(device_, bulletVertexBufferMemory_, nullptr);
+    allocator_->free(titleTextVertexBufferMemory_);
 
     vkDestroyBuffer(device_, overlayVertexBuffer_, nullptr);
-    vkFreeMemory(device_, overlayVertexBufferMemory_, nullptr);
+    allocator_->free(overlayVertexBufferMemory_);
 
     vkDestroyBuffer(device_, particlesVertexBuffer_, nullptr);
-    vkFreeMemory(device_, particlesVertexBufferMemory_, nullptr);
+    allocator_->free(particlesVertexBufferMemory_);
 
     vkDestroyBuffer(device_, particlesIndexBuffer_, nullptr);
-    vkFreeMemory(device_, particlesIndexBufferMemory_, nullptr);
-
-    vkDestroyBuffer(device_, particlesInstanceBuffer_, nullptr);
-    vkFreeMemory(device_, particlesInstanceBufferMemory_, nullptr);
-
-    if (shipVertexBuffer_ != VK_NULL_HANDLE)
-        vkDestroyBuffer(device_, shipVertexBuffer_, nullptr);
-    if (shipVertexBufferMemory_ != VK_NULL_HANDLE)
-        vkFreeMemory(device_, shipVertexBufferMemory_, nullptr);
-    if (imageAvailableSemaphore_ != VK_NULL_HANDLE)
-        vkDestroySemaphore(device_, imageAvailableSemaphore_, nullptr);
-    if (renderFinishedSemaphore_ != VK_NULL_HANDLE)
-        vkDestroySemaphore(device_, renderFinishedSemaphore_, nullptr);
+    allocator_->free(particlesIndexBufferMemory_);
+
+    uploadRing_.reset();
+    for (auto &frame: frames_) {
+        if (frame.imageAvailable != VK_NULL_HANDLE)
+            vkDestroySemaphore(device_, frame.imageAvailable, nullptr);
+        if (frame.inFlight != VK_NULL_HANDLE)
+            vkDestroyFence(device_, frame.inFlight, nullptr);
+    }
+    for (auto semaphore: renderFinished_)
+        vkDestroySemaphore(device_, semaphore, nullptr);
+
     if (mainDescriptorPool_ != VK_NULL_HANDLE)
         vkDestroyDescriptorPool(device_, mainDescriptorPool_, nullptr);
     if (uniformBuffer_ != VK_NULL_HANDLE)
         vkDestroyBuffer(device_, uniformBuffer_, nullptr);
 
-    if (uniformBufferMemory_ != VK_NULL_HANDLE) {
-        if (uniformBuffersData) {
-            vkUnmapMemory(device_, uniformBufferMemory_);
-        }
-        vkFreeMemory(device_, uniformBufferMemory_, nullptr);
-    }
+    allocator_->free(uniformBufferMemory_);
 
     if (vertexBuffer_ != VK_NULL_HANDLE) {
         vkDestroyBuffer(device_, vertexBuffer_, nullptr);
     }
-    if (vertexBufferMemory_ != VK_NULL_HANDLE) {
-        vkFreeMemory(device_, vertexBufferMemory_, nullptr);
-    }
+    allocator_->free(vertexBufferMemory_);
 
     for (auto framebuffer: framebuffers_) {
         vkDestroyFramebuffer(device_, framebuffer, nullptr);
@@ -2497,21 +2781,35 @@ Renderer::~Renderer() {
     for (auto imageView: swapchainImageViews_) {
         vkDestroyImageView(device_, imageView, nullptr);
     }
+    // headless targets are ours, swapchain images belong to the swapchain
+    for (size_t i = 0; i < offscreenImageMemory_.size(); ++i) {
+        vkDestroyImage(device_, swapchainImages_[i], nullptr);
+        allocator_->free(offscreenImageMemory_[i]);
+    }
 
     vkDestroyCommandPool(device_, commandPool_, nullptr);
+    uploadContext_.reset();
+    pipelines_.reset();
+    shaderModules_.reset();
+    perfHud_.reset();
+    gpuParticles_.reset();
 
-    if (surface_ != VK_NULL_HANDLE) {
-        vkDestroySurfaceKHR(instance_, surface_, nullptr);
-    }
-    if (instance_ != VK_NULL_HANDLE) {
-        vkDestroyInstance(instance_, nullptr);
-    }
+    // anything not freed above (e.g. power-up textures) goes with its block here
+    allocator_.reset();
+
+    // children before parents, the loader aborts on a device whose instance is already gone
     if (swapchain_ != VK_NULL_HANDLE) {
         vkDestroySwapchainKHR(device_, swapchain_, nullptr);
     }
     if (device_ != VK_NULL_HANDLE) {
         vkDestroyDevice(device_, nullptr);
     }
+    if (surface_ != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance_, surface_, nullptr);
+    }
+    if (instance_ != VK_NULL_HANDLE) {
+        vkDestroyInstance(instance_, nullptr);
+    }
 
 
 }
@@ -2519,13 +2817,14 @@ Renderer::~Renderer() {
 
 void Renderer::alienFireBullet() {
     if (gameState == GameState::Playing) {
-        static float timer = 0.0f;
-        timer += Time::deltaTime;
-        if (timer > 1.0f) {
-            timer = 0.0f;
-            Alien alien = aliens_[Util::getRandomUint(0, MAX_ALIENS)];
-            if (alien.active) {
-                spawnBullet(BulletType::Alien, {alien.x, -alien.y});
+        alienFireTimer_ += Time::deltaTime;
+        if (alienFireTimer_ > 1.0f) {
+            alienFireTimer_ = 0.0f;
+            // bottom-most alien of a random live column, the ones above would shoot their own
+            int shooter = aliens_.pickShooter(Util::getRandomUint(0, UINT32_MAX));
+            if (shooter >= 0) {
+                glm::vec2 pos = aliens_.position(shooter);
+                spawnBullet(BulletType::Alien, {pos.x, -pos.y});
             }
         }
 
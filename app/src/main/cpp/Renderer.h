@@ -4,9 +4,28 @@
 #include "ParticleSystem.h"
 #include <memory>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "Time.h"
 #include "PowerUpManager.h"
 #include "Util.h"
+#include "AssetLoader.h"
+#include "SpriteBatch.h"
+#include "UploadRing.h"
+#include "MemoryAllocator.h"
+#include "UploadContext.h"
+#include "SamplerCache.h"
+#include "TextureArray.h"
+#include "PipelineRegistry.h"
+#include "ShaderModuleCache.h"
+#include "PerfHud.h"
+#include "GpuParticles.h"
+#include "AlienFormation.h"
+#include "EntityStore.h"
+#include "FrameSnapshot.h"
+#include "TripleBuffer.h"
+#include "JobSystem.h"
 
 static constexpr int NUM_ALIENS_X = 8;
 static constexpr int NUM_ALIENS_Y = 3;
@@ -14,18 +33,92 @@ static constexpr int MAX_ALIENS = NUM_ALIENS_X * NUM_ALIENS_Y;
 constexpr int SFX_SAMPLE_RATE = 44100;
 constexpr int SFX_CHANNELS = 1;
 
-static constexpr int MAX_BULLETS = 50;
+// starting size of the entity pools, they grow if a wave ever needs more
+static constexpr uint32_t ENTITY_START_CAPACITY = 64;
+
+// upper bound, the actual count is picked at construction (1 = old wait-idle behaviour)
+static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+static constexpr int FRAME_TIMING_LOG_INTERVAL = 300;
+// frames recorded after startup when tracing is switched on from the device
+static constexpr uint32_t TRACE_CAPTURE_FRAMES = 600;
+// slice of the upload ring each frame in flight gets for instances/text/debug geometry
+static constexpr VkDeviceSize UPLOAD_RING_FRAME_SIZE = 1024 * 1024;
+// explosion particle budget when they're simulated on the GPU (CPU path stays at MAX_PARTICLES)
+static constexpr uint32_t GPU_PARTICLE_CAPACITY = 128 * 1024;
+
+// everything the CPU touches while recording/updating a frame, one copy per frame in flight
+// so we never write into something the GPU might still be reading
+struct FrameData {
+    VkCommandBuffer cmd{VK_NULL_HANDLE};
+    VkSemaphore imageAvailable{VK_NULL_HANDLE};
+    VkFence inFlight{VK_NULL_HANDLE};
+
+    // where this frame's dynamic data landed in the upload ring, rewritten every frame
+    UploadRing::Allocation particlesInstances;
+    UploadRing::Allocation starInstances;
+    UploadRing::Allocation haloInstance;
+    UploadRing::Allocation scoreTextVertices;
+    UploadRing::Allocation spriteInstances;
+    UploadRing::Allocation hudTextVertices; // invalid while the perf HUD is off
+};
+
+// a pipeline handed to the registry that finishPipelines() still has to hook up
+struct PendingPipeline {
+    GfxPipelineType type;
+    uint64_t key;
+    VkPipelineLayout layout;
+};
 
 
 class Renderer {
 public:
-    explicit Renderer(android_app *app);
+#ifdef __ANDROID__
+    explicit Renderer(android_app *app, uint32_t framesInFlight = 2);
+#endif
+
+    // headless mode: no surface/swapchain, renders into offscreen images and reads assets
+    // from a plain directory (e.g. app/src/main/assets), works with lavapipe/swiftshader.
+    // The pipeline cache is only persisted if pipelineCacheDir is set
+    Renderer(const std::string &assetDir, uint32_t width, uint32_t height,
+             uint32_t framesInFlight = 2, const std::string &pipelineCacheDir = "");
 
     ~Renderer();
 
+    // runs the game for the frame's time and snapshots it. Without a render thread the snapshot
+    // is recorded and presented right here, with one it's handed over and this only waits if
+    // the render thread is still a whole frame behind
     void drawFrame();
 
-    void updateShipBuffer() const;
+    // records + submits + presents from snapshots on a thread of its own, so the next frame's
+    // simulation overlaps this one's Vulkan work. Start it before calling drawFrame() and only
+    // from the thread that calls drawFrame()
+    void startRenderThread();
+
+    // renders whatever was already handed over, then joins
+    void stopRenderThread();
+
+    // replaces the job system the update phases run on (init() starts one with the default
+    // worker count). Only between frames, from the thread that calls drawFrame()
+    void startJobSystem(uint32_t workerCount, bool pinWorkers);
+
+    // hash of everything gameplay depends on, equal between two runs that played the same
+    uint32_t stateChecksum();
+
+    // while enabled every tick appends its stateChecksum(), takeTickChecksums() hands the ones
+    // since the last call over (Replay)
+    void setTickChecksums(bool enabled);
+
+    void takeTickChecksums(std::vector<uint32_t> &checksums);
+
+    // frame/CPU phase/GPU pass timings drawn over the game, stays on once enabled
+    void enablePerfHud();
+
+    const PerfHud *perfHud() const { return perfHud_.get(); }
+
+    // headless only: copies the last rendered image back as tightly packed RGBA8
+    bool readPixels(std::vector<uint8_t> &rgba, uint32_t &width, uint32_t &height);
+
+    void updateShipBuffer();
 
     void spawnBullet(BulletType bulletType,glm::vec2 spawnPos);
 
@@ -35,15 +128,18 @@ public:
     float lastFireTime = 0.0f;
     bool canFire = false;
 
-    MainPushConstants shipPC_ = {.texturePos=0};
-    MainPushConstants bulletPC_[MAX_BULLETS] = {};
-    MainPushConstants alienPC_[MAX_ALIENS] = {};
+    SpriteInstance shipSprite_ = {.texturePos=0};
+    SpriteInstance alienSprites_[MAX_ALIENS] = {};
     // In your renderer, have a shake timer and amplitude:
     float shakeTimer = 0.0f;   // seconds remaining
+    Broadphase broadphase_;
+    // ship, bullets and falling power-ups
+    std::shared_ptr<EntityStore> entities_;
+    EntityHandle shipEntity_;
     float shakeMagnitude = 0.025f; // NDC units (tune as desired)
     glm::vec2 shakeOffset{0.0f};
 
-    GameState gameState;
+    GameState gameState = GameState::Playing;
 
 
     void restartGame();
@@ -55,29 +151,82 @@ public:
 private:
     std::unique_ptr<FontManager> fontManager_;
     std::unique_ptr<ParticleSystem> particleSystem_;
+    std::unique_ptr<MemoryAllocator> allocator_;
+    std::unique_ptr<UploadRing> uploadRing_;
+    std::unique_ptr<UploadContext> uploadContext_;
+    std::unique_ptr<SamplerCache> samplerCache_;
+    std::unique_ptr<TextureArray> spriteTextures_;
+    std::unique_ptr<PipelineRegistry> pipelines_;
+    std::unique_ptr<ShaderModuleCache> shaderModules_;
+    std::unique_ptr<PerfHud> perfHud_;
+    std::unique_ptr<GpuParticles> gpuParticles_; // null = CPU particles
+    std::vector<PendingPipeline> pendingPipelines_;
+
+    // game thread -> render thread. The mutex only parks whichever side has nothing to do, the
+    // snapshots themselves go through the triple buffer's atomic
+    TripleBuffer<FrameSnapshot> snapshots_;
+    std::thread renderThread_;
+    std::mutex renderMutex_;
+    std::condition_variable renderWake_;
+    bool renderThreadStopping_ = false;
+    // update phases of a tick and of a frame, rebuilt every time they run
+    std::unique_ptr<JobSystem> jobs_;
+    JobGraph tickGraph_;
+    JobGraph frameGraph_;
+    // screen shake only, gameplay randomness is Util's so the frame rate can't shift it
+    std::mt19937 shakeRng_;
+    float alienFireTimer_ = 0.0f;
+    bool checksumTicks_ = false;
+    std::vector<uint32_t> tickChecksums_;
     std::shared_ptr<PowerUpManager> powerUpManager_;
     std::shared_ptr<Util> util_;
     UniformBufferObject ubo_;
-    android_app *app_;
-    AAssetManager *assetManager_; // assetmgr
+#ifdef __ANDROID__
+    android_app *app_ = nullptr;
+#endif
+    std::unique_ptr<AssetLoader> assetLoader_;
+    bool headless_ = false;
+    std::string pipelineCacheDir_; // app internal storage on Android
+    std::string traceFile_; // empty = not capturing
+    uint32_t tracedFrames_ = 0;
     VkInstance instance_{VK_NULL_HANDLE};
     VkSurfaceKHR surface_{VK_NULL_HANDLE};
     VkPhysicalDevice physicalDevice_{VK_NULL_HANDLE};
     VkDevice device_{VK_NULL_HANDLE};
     VkQueue graphicsQueue_{VK_NULL_HANDLE};
     uint32_t graphicsQueueFamily_ = UINT32_MAX;
+    VkQueue transferQueue_{VK_NULL_HANDLE}; // same as graphicsQueue_ without a transfer-only family
+    uint32_t transferQueueFamily_ = UINT32_MAX;
+    VkExtent3D transferImageGranularity_{1, 1, 1}; // of transferQueueFamily_
     VkSwapchainKHR swapchain_{VK_NULL_HANDLE};
     VkFormat swapchainFormat_;
     VkExtent2D swapchainExtent_;
     std::vector<VkImage> swapchainImages_;
     std::vector<VkImageView> swapchainImageViews_;
+    std::vector<MemoryAllocation> offscreenImageMemory_; // headless targets stand in for swapchain images
+    int32_t lastRenderedImage_ = -1;
     VkRenderPass renderPass_{VK_NULL_HANDLE};
     std::vector<VkFramebuffer> framebuffers_;
     VkCommandPool commandPool_{VK_NULL_HANDLE};
-    std::vector<VkCommandBuffer> commandBuffers_;
     VkCommandBuffer cmd_;
+
+    uint32_t framesInFlight_ = 2;
+    uint32_t currentFrame_ = 0;
+    FrameData frames_[MAX_FRAMES_IN_FLIGHT];
+    std::vector<VkFence> imagesInFlight_; // fence of the frame that last used each swapchain image
+    // per swapchain image, not per frame: a frame's fence says nothing about the present that
+    // waits on its semaphore, but an image only comes back from acquire once that present is done
+    std::vector<VkSemaphore> renderFinished_;
+
+    // frame timing, logged every FRAME_TIMING_LOG_INTERVAL frames
+    std::chrono::steady_clock::time_point lastFrameStart_{};
+    double frameTimeAccumMs_ = 0.0;
+    double fenceWaitAccumMs_ = 0.0;
+    double recordAccumMs_ = 0.0;
+    uint32_t frameTimeSamples_ = 0;
+
     VkBuffer vertexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory vertexBufferMemory_{VK_NULL_HANDLE};
+    MemoryAllocation vertexBufferMemory_;
 
     VkDescriptorSetLayout shipDescriptorSetLayout_{VK_NULL_HANDLE};
     VkDescriptorSetLayout overlayDescriptorSetLayout_{VK_NULL_HANDLE};
@@ -93,59 +242,26 @@ private:
     VkDescriptorSet overlayDescriptorSet_{VK_NULL_HANDLE};
 
     VkBuffer uniformBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory uniformBufferMemory_{VK_NULL_HANDLE};
+    MemoryAllocation uniformBufferMemory_;
 
     VkDescriptorPool mainDescriptorPool_{VK_NULL_HANDLE};
 
     VkDescriptorSet shipDescriptorSet_{VK_NULL_HANDLE};
 
-    VkSemaphore imageAvailableSemaphore_{VK_NULL_HANDLE};
-    VkSemaphore renderFinishedSemaphore_{VK_NULL_HANDLE};
-
-    VkBuffer shipVertexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory shipVertexBufferMemory_{VK_NULL_HANDLE};
-
     VkBuffer overlayVertexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory overlayVertexBufferMemory_{VK_NULL_HANDLE};
-
-    VkBuffer bulletVertexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory bulletVertexBufferMemory_{VK_NULL_HANDLE};
-
-    VkBuffer alienVertexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory alienVertexBufferMemory_{VK_NULL_HANDLE};
+    MemoryAllocation overlayVertexBufferMemory_;
 
     void *uniformBuffersData{nullptr};
 
     VkImage overlayImage_{VK_NULL_HANDLE};
-    VkDeviceMemory overlayImageDeviceMemory_{VK_NULL_HANDLE};
+    MemoryAllocation overlayImageDeviceMemory_;
 
     VkImageView overlayImageView_{VK_NULL_HANDLE};
     VkSampler overlaySampler_{VK_NULL_HANDLE};
 
-    VkImage shipImage_{VK_NULL_HANDLE};
-    VkDeviceMemory shipImageDeviceMemory_{VK_NULL_HANDLE};
-
-    VkImageView shipImageView_{VK_NULL_HANDLE};
-    VkSampler shipSampler_{VK_NULL_HANDLE};
-
-
-    VkImage alienImage_{VK_NULL_HANDLE};
-    VkDeviceMemory alienImageDeviceMemory_{VK_NULL_HANDLE};
-
-    VkImageView alienImageView_{VK_NULL_HANDLE};
-    VkSampler alienSampler_{VK_NULL_HANDLE};
-
-    VkImage shipBulletImage_{VK_NULL_HANDLE};
-    VkDeviceMemory shipBulletImageDeviceMemory_{VK_NULL_HANDLE};
-
-    VkImageView shipBulletImageView_{VK_NULL_HANDLE};
-    VkSampler shipBulletSampler_{VK_NULL_HANDLE};
-
     VkBuffer titleTextVertexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory titleTextVertexBufferMemory_{VK_NULL_HANDLE};
+    MemoryAllocation titleTextVertexBufferMemory_;
 
-    VkBuffer scoreTextVertexBuffer_;
-    VkDeviceMemory scoreTextVertexBufferMemory_;
 
     // Score tracking and animation
     int actualScore = 0;            // Game logic value
@@ -159,39 +275,23 @@ private:
     float scorePopAmount_ = 0.0022f;   // How much to “pop” the score on change
 
     VkBuffer particlesVertexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory particlesVertexBufferMemory_{VK_NULL_HANDLE};
+    MemoryAllocation particlesVertexBufferMemory_;
 
     VkBuffer particlesIndexBuffer_{VK_NULL_HANDLE};
-    VkDeviceMemory particlesIndexBufferMemory_{VK_NULL_HANDLE};
-
-    VkBuffer particlesInstanceBuffer_;
-    VkDeviceMemory particlesInstanceBufferMemory_;
+    MemoryAllocation particlesIndexBufferMemory_;
 
     VkBuffer starVertsBuffer_;
-    VkDeviceMemory starVertsMemory_;
+    MemoryAllocation starVertsMemory_;
 
     VkBuffer starIndexBuffer_;
-    VkDeviceMemory starIndexMemory_;
-
-    VkBuffer starInstanceBuffer_;
-    VkDeviceMemory starInstanceBufferMemory_;
+    MemoryAllocation starIndexMemory_;
 
 
     VkImage fontAtlasImage_;
-    VkDeviceMemory fontAtlasImageDeviceMemory_;
+    MemoryAllocation fontAtlasImageDeviceMemory_;
     VkImageView fontAtlasImageView_;
     VkSampler fontAtlasSampler_;
 
-    VkImage doubleShotImage_;
-    VkDeviceMemory doubleShotMemory_;
-    VkImageView doubleShotView_;
-    VkSampler doubleShotSampler_;
-
-    VkImage shieldImage_;
-    VkDeviceMemory shieldMemory_;
-    VkImageView shieldView_;
-    VkSampler shieldSampler_;
-
     VkPipeline fontPipeline_{VK_NULL_HANDLE};
     VkPipelineLayout fontPipelineLayout_{VK_NULL_HANDLE};
     VkDescriptorSet fontDescriptorSet_{VK_NULL_HANDLE};
@@ -201,17 +301,54 @@ private:
 
     VkPipeline explosionParticlesPipeline_{VK_NULL_HANDLE};
     VkPipelineLayout particlesPipelineLayout_{VK_NULL_HANDLE};
+    VkPipeline gpuParticlesPipeline_{VK_NULL_HANDLE};
     VkDescriptorSet particlesDescriptorSet_{VK_NULL_HANDLE};
     VkDescriptorPool particlesDescriptorPool_{VK_NULL_HANDLE};
     VkDescriptorSetLayout particlesDescriptorSetLayout_{VK_NULL_HANDLE};
 
     VkPipeline starParticlesPipeline_{VK_NULL_HANDLE};
+    VkPipeline proceduralStarsPipeline_{VK_NULL_HANDLE};
+    VkPipelineLayout proceduralStarsPipelineLayout_{VK_NULL_HANDLE};
+
+    void buildSpriteBatch(SpriteBatch &spriteBatch);
 
-    void recordCommandBuffer(uint32_t imageIndex);
+    void createUploadRing();
+
+    // game thread half of drawFrame()
+    void simulateFrame(FrameSnapshot &snapshot);
+
+    // render thread half: waits for the frame slot, uploads the snapshot, records, submits
+    void renderFrame(const FrameSnapshot &snapshot);
+
+    void renderLoop();
+
+    void recordCommandBuffer(uint32_t imageIndex, const FrameSnapshot &snapshot);
+
+    void init();
 
     void initVulkan();
 
-    static void updateBullet();
+    void createSwapchain();
+
+    void createOffscreenTargets();
+
+    void createFrameResources();
+
+    void finishFrame(std::chrono::steady_clock::time_point frameStart, double fenceWaitMs,
+                     double recordMs);
+
+    void logFrameTiming(double frameMs, double fenceWaitMs, double recordMs);
+
+    // moves every entity and drops the bullets that left the screen
+    void updateEntities();
+
+    // one fixed step of gameplay, Time::deltaTime is the tick length
+    void simulateTick();
+
+    void simulatePlayingTick();
+
+    // canFire goes up once every rateOfFire
+    void updateFireTimer();
 
     void updateAliens();
 
@@ -221,8 +358,15 @@ private:
 
     void updateGameState();
 
+    // queues the pipeline, the handle is only assigned by finishPipelines()
     void createPipeline(GfxPipelineData &gfxPipelineData,GfxPipelineType gfxPipelineType);
 
+    void finishPipelines();
+
+    void assignPipeline(const GfxPipelineData &gfxPipelineData, GfxPipelineType gfxPipelineType);
+
+    void writeDescriptorSets();
+
     void createPipelineLayout(VkPipelineLayoutCreateInfo &pipelineLayoutInfo,GfxPipelineData &gfxPipelineData);
 
     void createDescriptorSetLayout(VkDescriptorSetLayoutCreateInfo info, VkDescriptorSetLayout &layout);
@@ -236,13 +380,18 @@ private:
 
     void createImageOverlayDescriptor(GfxPipelineData &gfxPipelineData);
 
-    void loadTexture(const char *filename, VkImage &vkImage, VkDeviceMemory &vkDeviceMemory,
+    void loadTexture(const char *filename, VkImage &vkImage, MemoryAllocation &vkDeviceMemory,
                      VkImageView &imageView, VkSampler &vkSampler, GameTextureType gameTextureType);
 
+    // decodes straight into a layer of spriteTextures_
+    void loadSpriteTexture(const char *filename, GameTextureType gameTextureType);
+
     void createOverlayGfxPipeline();
 
     void loadAllTextures();
 
+    void loadAudio();
+
     void createMainDescriptor(GfxPipelineData &gfxPipelineData);
 
     void createFontGfxPipeline();
@@ -266,7 +415,7 @@ private:
 
     void createGfxPipeline(GfxPipelineType gfxPipelineType);
 
-    void createAndUploadBuffer(const void *vertices, VkBuffer &buffer, VkDeviceMemory &bufferMemory,
+    void createAndUploadBuffer(const void *vertices, VkBuffer &buffer, MemoryAllocation &bufferMemory,
                                VkDeviceSize size,VkBufferUsageFlags usage);
 
     void alienFireBullet();
@@ -0,0 +1,189 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "Replay.h"
+#include "Renderer.h"
+#include "Time.h"
+#include "Util.h"
+#include <cstdio>
+#include <stdexcept>
+
+using Clock = std::chrono::steady_clock;
+
+Replay::Replay(ReplayMode mode, const std::string &path, bool checksums)
+        : mode_(mode) {
+    if (mode_ == ReplayMode::Record) {
+        file_ = fopen(path.c_str(), "wb");
+        if (!file_) {
+            LOGE("Replay: can't write %s", path.c_str());
+            throw std::runtime_error("failed to open replay for writing");
+        }
+        seed_ = std::random_device{}();
+        flags_ = checksums ? FLAG_CHECKSUMS : 0;
+    } else {
+        FILE *in = fopen(path.c_str(), "rb");
+        if (!in) {
+            LOGE("Replay: can't read %s", path.c_str());
+            throw std::runtime_error("failed to open replay");
+        }
+        uint8_t buffer[64 * 1024];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+            data_.insert(data_.end(), buffer, buffer + read);
+        }
+        fclose(in);
+        uint32_t magic = 0;
+        uint16_t version = 0;
+        if (!get(magic) || magic != MAGIC || !get(version) || version != VERSION ||
+            !get(flags_) || !get(seed_) || !get(tickRate_) || tickRate_ <= 0.0f) {
+            LOGE("Replay: %s isn't a version %u replay", path.c_str(), VERSION);
+            throw std::runtime_error("not a replay");
+        }
+    }
+    Util::seed(seed_);
+}
+
+Replay::~Replay() {
+    if (!file_) return;
+    flush();
+    fclose(file_);
+}
+
+void Replay::recordInput(const ReplayEvent &event) {
+    if (mode_ == ReplayMode::Record) pendingEvents_.push_back(event);
+}
+
+void Replay::start(Renderer &renderer) {
+    // the tick rate is only settled now, whatever set it up after the constructor (setprop,
+    // command line) has run. Whatever time piled up before the first frame doesn't count
+    if (mode_ == ReplayMode::Record) {
+        tickRate_ = 1.0f / Time::tickDeltaTime;
+        put(MAGIC);
+        put(VERSION);
+        put(flags_);
+        put(seed_);
+        put(tickRate_);
+    } else {
+        Time::setTickRate(tickRate_);
+    }
+    Time::reset();
+    renderer.setTickChecksums((flags_ & FLAG_CHECKSUMS) != 0);
+    start_ = Clock::now();
+}
+
+bool Replay::beginFrame(Renderer &renderer, float frameDelta) {
+    if (ended_) return false;
+    if (frameCount_ == 0) start(renderer);
+
+    if (mode_ == ReplayMode::Record) {
+        put(uint16_t(pendingEvents_.size()));
+        put(frameDelta);
+        for (const ReplayEvent &event: pendingEvents_) {
+            put(event.type);
+            put(event.position.x);
+            put(event.position.y);
+        }
+        pendingEvents_.clear();
+        Time::advance(frameDelta);
+        return true;
+    }
+
+    // a log cut short (app killed mid write) just ends at the last whole frame
+    size_t frameStart = cursor_;
+    uint16_t eventCount;
+    if (!get(eventCount) || !get(frameDelta) ||
+        data_.size() - cursor_ < size_t(eventCount) * (sizeof(uint8_t) + 2 * sizeof(float))) {
+        cursor_ = frameStart;
+        ended_ = true;
+        end_ = Clock::now();
+        renderer.setTickChecksums(false);
+        return false;
+    }
+    for (uint16_t i = 0; i < eventCount; ++i) {
+        ReplayEvent event{};
+        get(event.type);
+        get(event.position.x);
+        get(event.position.y);
+        apply(renderer, event);
+    }
+    Time::advance(frameDelta);
+    return true;
+}
+
+void Replay::endFrame(Renderer &renderer) {
+    if (ended_) return;
+    renderer.takeTickChecksums(checksums_);
+    frameCount_++;
+    tickCount_ += checksums_.size();
+    end_ = Clock::now();
+
+    if (mode_ == ReplayMode::Record) {
+        if (flags_ & FLAG_CHECKSUMS) {
+            put(uint16_t(checksums_.size()));
+            for (uint32_t checksum: checksums_) put(checksum);
+        }
+        if (frameCount_ % FLUSH_INTERVAL == 0) flush();
+        return;
+    }
+
+    if (!(flags_ & FLAG_CHECKSUMS)) return;
+    uint16_t tickCount;
+    if (!get(tickCount)) return;   // cut short, the next beginFrame() ends it
+    for (uint16_t i = 0; i < tickCount || i < checksums_.size(); ++i) {
+        uint32_t recorded = 0;
+        bool have = i < tickCount && get(recorded);
+        if (have && i < checksums_.size() && recorded == checksums_[i]) continue;
+        // a differing tick count is a mismatch too, the frame ran ticks the recording didn't
+        if (mismatchCount_++ == 0) {
+            firstMismatchFrame_ = frameCount_ - 1;
+            firstMismatchTick_ = i;
+            LOGE("Replay: state differs from the recording at frame %u tick %u",
+                 firstMismatchFrame_, firstMismatchTick_);
+        }
+    }
+}
+
+std::string Replay::summary() const {
+    double ms = std::chrono::duration<double, std::milli>(end_ - start_).count();
+    char buffer[256];
+    int length = snprintf(buffer, sizeof(buffer),
+                          "replay %s: %u frames, %llu ticks in %.1f ms (avg %.3f ms/frame)",
+                          mode_ == ReplayMode::Record ? "recorded" : "played", frameCount_,
+                          (unsigned long long) tickCount_, ms,
+                          frameCount_ ? ms / frameCount_ : 0.0);
+    std::string text(buffer, size_t(length));
+    if (mode_ == ReplayMode::Playback && (flags_ & FLAG_CHECKSUMS)) {
+        if (mismatchCount_ == 0) {
+            snprintf(buffer, sizeof(buffer), ", every tick matched\n");
+        } else {
+            snprintf(buffer, sizeof(buffer),
+                     ", %u ticks differ, first at frame %u tick %u\n", mismatchCount_,
+                     firstMismatchFrame_, firstMismatchTick_);
+        }
+        text += buffer;
+    } else {
+        text += "\n";
+    }
+    return text;
+}
+
+void Replay::apply(Renderer &renderer, const ReplayEvent &event) {
+    switch (event.type) {
+        case ReplayEventType::Touch:
+            renderer.shipX_ = event.position.x;
+            renderer.shipY_ = event.position.y - 0.12f;
+            renderer.spawnBullet(BulletType::Ship, {event.position.x, event.position.y - 0.12f});
+            break;
+        case ReplayEventType::Restart:
+            renderer.restartGame();
+            break;
+    }
+}
+
+void Replay::flush() {
+    if (data_.empty()) return;
+    fwrite(data_.data(), 1, data_.size(), file_);
+    fflush(file_);
+    data_.clear();
+}
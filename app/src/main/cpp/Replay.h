@@ -0,0 +1,128 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_REPLAY_H
+#define SPACEINVADERS3D_REPLAY_H
+
+#include "GameObjectData.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class Renderer;
+
+enum class ReplayMode {
+    Record,
+    Playback
+};
+
+enum class ReplayEventType : uint8_t {
+    Touch,     // finger down/move at position (NDC): moves the ship and fires
+    Restart    // tap once the game is over
+};
+
+struct ReplayEvent {
+    ReplayEventType type;
+    glm::vec2 position{0.0f};
+};
+
+// Records a session to a small binary log, or plays one back tick for tick. Gameplay randomness
+// all comes from Util's generator and gameplay only moves in fixed ticks, so the seed, the input
+// and every frame's delta time are enough to repeat a run exactly: same build + same CPU family
+// gives identical state, which makes a recorded session a benchmark that plays the same on any
+// build or device. Input is stamped with the frame it landed before, the game never looks at it
+// mid frame. With checksums on, every tick's Renderer::stateChecksum() goes in the log and
+// playback reports the first tick that came out different.
+//
+// Log, little endian:
+//     header: u32 magic, u16 version, u16 flags, u32 seed, f32 tick rate
+//     per frame: u16 event count, f32 frame delta, events (u8 type, f32 x, f32 y),
+//                with FLAG_CHECKSUMS u16 tick count + a u32 checksum per tick
+//
+// Make it before the Renderer, it seeds Util's generator which the Renderer seeds its own from.
+class Replay {
+public:
+    // Record: picks a seed, writes to path. Playback: loads path and seeds from it. Throws if
+    // the file can't be opened or isn't a replay. checksums only matters when recording
+    Replay(ReplayMode mode, const std::string &path, bool checksums = true);
+
+    ~Replay();
+
+    Replay(const Replay &) = delete;
+
+    Replay &operator=(const Replay &) = delete;
+
+    bool playing() const { return mode_ == ReplayMode::Playback; }
+
+    // live input that was just applied, it's written with the coming frame. Drop live input
+    // instead while playing()
+    void recordInput(const ReplayEvent &event);
+
+    // Call instead of Time::updateTime(), before drawFrame(). Recording stores frameDelta and
+    // advances Time by it, playback applies the next frame's input and recorded delta instead.
+    // False once the playback has run out of frames
+    bool beginFrame(Renderer &renderer, float frameDelta);
+
+    // after drawFrame(), stores or checks the ticks' checksums
+    void endFrame(Renderer &renderer);
+
+    uint32_t frameCount() const { return frameCount_; }
+
+    uint32_t mismatchCount() const { return mismatchCount_; }
+
+    // frames, wall time and the checksum verdict
+    std::string summary() const;
+
+    // what live input does to the game, shared with the replay so both do exactly the same
+    static void apply(Renderer &renderer, const ReplayEvent &event);
+
+private:
+    static constexpr uint32_t MAGIC = 0x50524953;   // "SIRP"
+    static constexpr uint16_t VERSION = 2; // 2: explosions got their own generator
+    static constexpr uint16_t FLAG_CHECKSUMS = 1;
+    // written out every this many frames, so a killed app still leaves most of its log
+    static constexpr uint32_t FLUSH_INTERVAL = 120;
+
+    ReplayMode mode_;
+    FILE *file_ = nullptr;                // recording only
+    std::vector<uint8_t> data_;           // recording: not yet written, playback: whole log
+    size_t cursor_ = 0;
+    uint16_t flags_ = 0;
+    uint32_t seed_ = 0;
+    float tickRate_ = 0.0f;
+
+    std::vector<ReplayEvent> pendingEvents_;
+    std::vector<uint32_t> checksums_;
+    uint32_t frameCount_ = 0;
+    uint64_t tickCount_ = 0;
+    uint32_t mismatchCount_ = 0;
+    uint32_t firstMismatchFrame_ = 0;
+    uint32_t firstMismatchTick_ = 0;
+    bool ended_ = false;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point end_;
+
+    void start(Renderer &renderer);
+
+    void flush();
+
+    template<typename T>
+    void put(const T &value) {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+        data_.insert(data_.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    bool get(T &value) {
+        if (data_.size() - cursor_ < sizeof(T)) return false;
+        memcpy(&value, data_.data() + cursor_, sizeof(T));
+        cursor_ += sizeof(T);
+        return true;
+    }
+};
+
+
+#endif //SPACEINVADERS3D_REPLAY_H
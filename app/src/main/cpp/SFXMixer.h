@@ -1,3 +1,4 @@
+#ifdef __ANDROID__
 #include "oboe/Oboe.h"
 
 struct SFXInstance {
@@ -61,3 +62,14 @@ public:
         return oboe::DataCallbackResult::Continue;
     }
 };
+#else
+// No audio backend on desktop (headless runs), keep the interface so gameplay code doesn't care
+#include <cstddef>
+
+class SFXMixer {
+public:
+    void start(int, int = 1) {}
+
+    void playSFX(const float *, size_t, float = 1.0f) {}
+};
+#endif
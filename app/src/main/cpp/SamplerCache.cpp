@@ -0,0 +1,42 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "SamplerCache.h"
+#include <stdexcept>
+
+SamplerCache::SamplerCache(VkDevice device) : device_(device) {}
+
+SamplerCache::~SamplerCache() {
+    for (auto &entry: samplers_) {
+        vkDestroySampler(device_, entry.second, nullptr);
+    }
+}
+
+VkSampler SamplerCache::get(VkFilter filter, VkSamplerAddressMode addressMode) {
+    uint32_t key = (static_cast<uint32_t>(filter) << 16) | static_cast<uint32_t>(addressMode);
+    auto it = samplers_.find(key);
+    if (it != samplers_.end()) return it->second;
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = filter;
+    samplerInfo.minFilter = filter;
+    samplerInfo.addressModeU = addressMode;
+    samplerInfo.addressModeV = addressMode;
+    samplerInfo.addressModeW = addressMode;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+
+    VkSampler sampler;
+    if (vkCreateSampler(device_, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        LOGE("Failed to create sampler (filter %d, address mode %d)", filter, addressMode);
+        throw std::runtime_error("Failed to create sampler");
+    }
+    samplers_[key] = sampler;
+    return sampler;
+}
@@ -0,0 +1,29 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_SAMPLERCACHE_H
+#define SPACEINVADERS3D_SAMPLERCACHE_H
+
+#include "GameObjectData.h"
+
+// Samplers only depend on their state, not on the image, so every texture with the same
+// filter/address mode shares one instead of each creating an identical VkSampler.
+class SamplerCache {
+public:
+    explicit SamplerCache(VkDevice device);
+
+    ~SamplerCache();
+
+    // owned by the cache, don't destroy
+    VkSampler get(VkFilter filter, VkSamplerAddressMode addressMode);
+
+    size_t size() const { return samplers_.size(); }
+
+private:
+    VkDevice device_{VK_NULL_HANDLE};
+    std::unordered_map<uint32_t, VkSampler> samplers_;
+};
+
+
+#endif //SPACEINVADERS3D_SAMPLERCACHE_H
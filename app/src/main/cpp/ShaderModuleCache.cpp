@@ -0,0 +1,46 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "ShaderModuleCache.h"
+#include "PipelineRegistry.h"
+#include <stdexcept>
+
+ShaderModuleCache::ShaderModuleCache(VkDevice device, const AssetLoader &assets)
+        : device_(device), assets_(assets) {}
+
+ShaderModuleCache::~ShaderModuleCache() {
+    clear();
+}
+
+const ShaderModuleCache::Module &ShaderModuleCache::get(const char *filename) {
+    auto it = modules_.find(filename);
+    if (it != modules_.end()) return it->second;
+
+    std::string fullPath = "shaders/" + std::string(filename);
+    std::vector<uint8_t> code = assets_.load(fullPath);
+    if (code.empty()) {
+        LOGE("Shader not found: %s", fullPath.c_str());
+        throw std::runtime_error("Shader not found!");
+    }
+
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+
+    Module module;
+    if (vkCreateShaderModule(device_, &createInfo, nullptr, &module.module) != VK_SUCCESS) {
+        LOGE("Failed to create shader module %s", filename);
+        throw std::runtime_error("Failed to create shader module");
+    }
+    module.hash = PipelineRegistry::hashBytes(code.data(), code.size());
+    return modules_[filename] = module;
+}
+
+void ShaderModuleCache::clear() {
+    for (auto &entry: modules_) {
+        vkDestroyShaderModule(device_, entry.second.module, nullptr);
+    }
+    modules_.clear();
+}
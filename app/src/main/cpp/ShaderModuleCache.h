@@ -0,0 +1,39 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_SHADERMODULECACHE_H
+#define SPACEINVADERS3D_SHADERMODULECACHE_H
+
+#include "GameObjectData.h"
+#include "AssetLoader.h"
+#include <string>
+
+// Loads each SPIR-V file from assets/shaders once and hands out the same VkShaderModule to every
+// pipeline that uses it. Modules are only needed until the pipelines are compiled, so clear()
+// right after that.
+class ShaderModuleCache {
+public:
+    struct Module {
+        VkShaderModule module{VK_NULL_HANDLE};
+        uint64_t hash{0}; // of the SPIR-V, module handles differ between runs
+    };
+
+    ShaderModuleCache(VkDevice device, const AssetLoader &assets);
+
+    ~ShaderModuleCache();
+
+    const Module &get(const char *filename);
+
+    void clear();
+
+    size_t size() const { return modules_.size(); }
+
+private:
+    VkDevice device_{VK_NULL_HANDLE};
+    const AssetLoader &assets_;
+    std::unordered_map<std::string, Module> modules_;
+};
+
+
+#endif //SPACEINVADERS3D_SHADERMODULECACHE_H
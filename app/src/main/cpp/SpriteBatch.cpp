@@ -0,0 +1,53 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "SpriteBatch.h"
+
+SpriteBatch::SpriteBatch(VkPipelineLayout pipelineLayout) : pipelineLayout_(pipelineLayout) {
+    sprites_.reserve(256);
+}
+
+void SpriteBatch::begin() {
+    sprites_.clear();
+    draws_.clear();
+}
+
+void SpriteBatch::add(VkPipeline pipeline, VkDescriptorSet descriptorSet,
+                      const SpriteInstance &sprite) {
+    if (draws_.empty() || draws_.back().pipeline != pipeline ||
+        draws_.back().descriptorSet != descriptorSet) {
+        draws_.push_back({pipeline, descriptorSet, static_cast<uint32_t>(sprites_.size()), 0});
+    }
+    draws_.back().instanceCount++;
+    sprites_.push_back(sprite);
+}
+
+UploadRing::Allocation SpriteBatch::upload(UploadRing &uploadRing) const {
+    if (sprites_.empty()) return {};
+    return uploadRing.push(sprites_.data(), byteSize());
+}
+
+void SpriteBatch::recordCommandBuffer(VkCommandBuffer cmd, VkBuffer quadVertexBuffer,
+                                      const UploadRing::Allocation &instances) const {
+    if (draws_.empty() || !instances.valid()) return;
+
+    VkDeviceSize offsets[] = {0, instances.offset};
+    VkBuffer vertexBuffers[] = {quadVertexBuffer, instances.buffer};
+    vkCmdBindVertexBuffers(cmd, 0, 2, vertexBuffers, offsets);
+
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkDescriptorSet boundSet = VK_NULL_HANDLE;
+    for (const auto &draw: draws_) {
+        if (draw.pipeline != boundPipeline) {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline);
+            boundPipeline = draw.pipeline;
+        }
+        if (draw.descriptorSet != boundSet) {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1,
+                                    &draw.descriptorSet, 0, nullptr);
+            boundSet = draw.descriptorSet;
+        }
+        vkCmdDraw(cmd, 6, draw.instanceCount, 0, draw.firstInstance);
+    }
+}
@@ -0,0 +1,50 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_SPRITEBATCH_H
+#define SPACEINVADERS3D_SPRITEBATCH_H
+
+#include "GameObjectData.h"
+#include "UploadRing.h"
+
+// Collects every sprite for the frame into one instance array and draws it with as few
+// vkCmdDraws as possible. Sprites sharing a pipeline + descriptor set that are added back to back
+// go into the same draw, so the texture (picked per instance via texturePos) doesn't split batches.
+// Submission order is kept, so draw order is the same as adding them one by one.
+class SpriteBatch {
+public:
+    SpriteBatch() = default;
+    explicit SpriteBatch(VkPipelineLayout pipelineLayout);
+
+    void begin();
+
+    void add(VkPipeline pipeline, VkDescriptorSet descriptorSet, const SpriteInstance &sprite);
+
+    // copies the instances into this frame's slice of the upload ring
+    UploadRing::Allocation upload(UploadRing &uploadRing) const;
+
+    void recordCommandBuffer(VkCommandBuffer cmd, VkBuffer quadVertexBuffer,
+                             const UploadRing::Allocation &instances) const;
+
+    size_t size() const { return sprites_.size(); }
+
+    size_t drawCount() const { return draws_.size(); }
+
+    VkDeviceSize byteSize() const { return sprites_.size() * sizeof(SpriteInstance); }
+
+private:
+    struct Draw {
+        VkPipeline pipeline;
+        VkDescriptorSet descriptorSet;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    VkPipelineLayout pipelineLayout_{VK_NULL_HANDLE};
+    std::vector<SpriteInstance> sprites_;
+    std::vector<Draw> draws_;
+};
+
+
+#endif //SPACEINVADERS3D_SPRITEBATCH_H
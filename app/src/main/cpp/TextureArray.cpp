@@ -0,0 +1,118 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "TextureArray.h"
+#include <stdexcept>
+
+// size of a corner copy rounded up to whole granularity blocks, or the full layer size when that
+// is reached first (or the queue only copies whole images, granularity 0)
+static uint32_t padToGranularity(uint32_t size, uint32_t granularity, uint32_t layerSize) {
+    if (granularity == 0) return layerSize;
+    return std::min(layerSize, (size + granularity - 1) / granularity * granularity);
+}
+
+TextureArray::TextureArray(VkDevice device, MemoryAllocator &allocator)
+        : device_(device), allocator_(allocator) {}
+
+TextureArray::~TextureArray() {
+    vkDestroyImageView(device_, view_, nullptr);
+    vkDestroyImage(device_, image_, nullptr);
+    allocator_.free(memory_);
+}
+
+void TextureArray::addLayer(GameTextureType type, const uint8_t *pixels, uint32_t width,
+                            uint32_t height, UploadContext &uploadContext) {
+    if (image_ != VK_NULL_HANDLE) {
+        LOGE("Texture array already built, can't add more layers");
+        throw std::runtime_error("Texture array already built");
+    }
+    UploadContext::Staging staging = uploadContext.allocateStaging(width * height * 4);
+    memcpy(staging.data, pixels, width * height * 4);
+    layers_.push_back({type, width, height, staging});
+    width_ = std::max(width_, width);
+    height_ = std::max(height_, height);
+}
+
+void TextureArray::build(UploadContext &uploadContext) {
+    if (layers_.empty()) return;
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = {width_, height_, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = layerCount();
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device_, &imageInfo, nullptr, &image_) != VK_SUCCESS) {
+        LOGE("Failed to create %ux%u texture array with %u layers", width_, height_,
+             layerCount());
+        throw std::runtime_error("Failed to create texture array");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device_, image_, &memRequirements);
+    memory_ = allocator_.allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    vkBindImageMemory(device_, image_, memory_.memory, memory_.offset);
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image_;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layerCount()};
+    if (vkCreateImageView(device_, &viewInfo, nullptr, &view_) != VK_SUCCESS) {
+        LOGE("Failed to create texture array view");
+        throw std::runtime_error("Failed to create texture array view");
+    }
+
+    VkExtent3D granularity = uploadContext.imageGranularity();
+    for (uint32_t i = 0; i < layerCount(); ++i) {
+        const Layer &layer = layers_[i];
+        // only the used corner gets copied, the rest of the layer is never sampled. A queue with
+        // a coarse transfer granularity can't copy an odd sized corner though, then the texture
+        // is restaged padded with transparent texels
+        uint32_t copyWidth = padToGranularity(layer.width, granularity.width, width_);
+        uint32_t copyHeight = padToGranularity(layer.height, granularity.height, height_);
+        UploadContext::Staging pixels = layer.pixels;
+        if (copyWidth != layer.width || copyHeight != layer.height) {
+            pixels = uploadContext.allocateStaging(copyWidth * copyHeight * 4);
+            memset(pixels.data, 0, copyWidth * copyHeight * 4);
+            for (uint32_t y = 0; y < layer.height; ++y) {
+                memcpy(static_cast<uint8_t *>(pixels.data) + y * copyWidth * 4,
+                       static_cast<const uint8_t *>(layer.pixels.data) + y * layer.width * 4,
+                       layer.width * 4);
+            }
+        }
+        uploadContext.uploadImage(image_, copyWidth, copyHeight, pixels, i);
+
+        SpriteRegion region;
+        region.layer = i;
+        if (layer.width < width_) {
+            region.uvRect.x = 0.5f / width_;
+            region.uvRect.z = (layer.width - 1.0f) / width_;
+        }
+        if (layer.height < height_) {
+            region.uvRect.y = 0.5f / height_;
+            region.uvRect.w = (layer.height - 1.0f) / height_;
+        }
+        regions_[layer.type] = region;
+    }
+    LOGE("Texture array: %u layers of %ux%u", layerCount(), width_, height_);
+    layers_.clear();
+}
+
+const SpriteRegion &TextureArray::region(GameTextureType type) const {
+    auto it = regions_.find(type);
+    if (it == regions_.end()) {
+        LOGE("No texture array layer for texture type %d", (int) type);
+        throw std::runtime_error("Missing texture array layer");
+    }
+    return it->second;
+}
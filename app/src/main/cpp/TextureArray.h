@@ -0,0 +1,57 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_TEXTUREARRAY_H
+#define SPACEINVADERS3D_TEXTUREARRAY_H
+
+#include "GameObjectData.h"
+#include "MemoryAllocator.h"
+#include "UploadContext.h"
+
+// All the sprite textures in one VK_IMAGE_VIEW_TYPE_2D_ARRAY image, one layer each, so the main
+// pipeline binds a single descriptor and new art is just another layer.
+// Layers are sized to the biggest texture; smaller ones sit in the top left corner and their
+// SpriteRegion uvRect only covers that part (inset by half a texel so filtering never picks up
+// the padding).
+class TextureArray {
+public:
+    TextureArray(VkDevice device, MemoryAllocator &allocator);
+
+    ~TextureArray();
+
+    // RGBA8, tightly packed. The pixels go straight into upload staging so they can be freed after
+    void addLayer(GameTextureType type, const uint8_t *pixels, uint32_t width, uint32_t height,
+                  UploadContext &uploadContext);
+
+    // creates the image/view and queues the layer copies, call once after all addLayer calls
+    void build(UploadContext &uploadContext);
+
+    const SpriteRegion &region(GameTextureType type) const;
+
+    VkImageView view() const { return view_; }
+
+    uint32_t layerCount() const { return static_cast<uint32_t>(layers_.size()); }
+
+private:
+    struct Layer {
+        GameTextureType type;
+        uint32_t width;
+        uint32_t height;
+        UploadContext::Staging pixels;
+    };
+
+    VkDevice device_{VK_NULL_HANDLE};
+    MemoryAllocator &allocator_;
+    VkImage image_{VK_NULL_HANDLE};
+    MemoryAllocation memory_;
+    VkImageView view_{VK_NULL_HANDLE};
+    uint32_t width_{0};
+    uint32_t height_{0};
+
+    std::vector<Layer> layers_;
+    std::unordered_map<GameTextureType, SpriteRegion> regions_;
+};
+
+
+#endif //SPACEINVADERS3D_TEXTUREARRAY_H
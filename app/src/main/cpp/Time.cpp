@@ -2,17 +2,59 @@
 // Created by carlo on 01/07/2025.
 //
 #include "Time.h"
+#include <algorithm>
 
 float Time::deltaTime = 0.0f;
+float Time::frameDeltaTime = 0.0f;
+float Time::tickDeltaTime = 1.0f / Time::DEFAULT_TICK_RATE;
+float Time::alpha = 1.0f;
+float Time::accumulator_ = 0.0f;
 using Clock = std::chrono::high_resolution_clock;
 static auto lastFrameTime = Clock::now();
 
 void Time::updateTime() {
-        auto now = Clock::now();
-        float actualDeltaTime = std::chrono::duration<float>(now - lastFrameTime).count();
-        actualDeltaTime = std::min(actualDeltaTime, 0.0167f);
-        lastFrameTime = now;
-        deltaTime = actualDeltaTime;
+    advance(clockDelta());
+}
+
+float Time::clockDelta() {
+    auto now = Clock::now();
+    float actualDeltaTime = std::chrono::duration<float>(now - lastFrameTime).count();
+    // collisions are swept so big steps are fine, this only stops a pause (debugger,
+    // app switch) from landing as one giant step
+    actualDeltaTime = std::min(actualDeltaTime, MAX_DELTA_TIME);
+    lastFrameTime = now;
+    return actualDeltaTime;
+}
+
+void Time::reset() {
+    deltaTime = 0.0f;
+    frameDeltaTime = 0.0f;
+    alpha = 1.0f;
+    accumulator_ = 0.0f;
+}
+
+void Time::advance(float frameDelta) {
+    frameDeltaTime = frameDelta;
+    deltaTime = frameDelta;
+    // capped too, nothing drains it until the renderer exists
+    accumulator_ = std::min(accumulator_ + frameDelta, MAX_DELTA_TIME);
+}
+
+void Time::setTickRate(float ticksPerSecond) {
+    // a tick longer than MAX_DELTA_TIME would never fit in the capped accumulator
+    tickDeltaTime = 1.0f / std::max(ticksPerSecond, 1.0f / MAX_DELTA_TIME);
+}
+
+bool Time::beginTick() {
+    // a hair of slack so a 30 fps frame is two 60 Hz ticks, not 1.9999 of them
+    if (accumulator_ >= tickDeltaTime * 0.999f) {
+        accumulator_ = std::max(accumulator_ - tickDeltaTime, 0.0f);
+        deltaTime = tickDeltaTime;
+        return true;
+    }
+    deltaTime = frameDeltaTime;
+    alpha = accumulator_ / tickDeltaTime;
+    return false;
 }
 
 Time::Time() = default;
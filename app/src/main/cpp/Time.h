@@ -5,18 +5,36 @@
 #ifndef SPACEINVADERS3D_TIME_H
 #define SPACEINVADERS3D_TIME_H
 
-#include "android_native_app_glue.h"
 #include <memory>
 #include <chrono>
 #include "GameObjectData.h"
+// Gameplay runs in fixed ticks so it plays the same at any refresh rate: updateTime() feeds the
+// frame's time into an accumulator and the renderer simulates with
+//     while (Time::beginTick()) { ... }
+// Inside the loop deltaTime is the tick length, after it it's the frame's delta again (for
+// purely visual stuff) and alpha says how far the frame is between the last two ticks.
 class Time {
 public:
+    static constexpr float MAX_DELTA_TIME = 0.25f;
+    static constexpr float DEFAULT_TICK_RATE = 60.0f;
     Time();
     ~Time();
     static float deltaTime;
+    static float frameDeltaTime;
+    static float tickDeltaTime;
+    // 0 = render the previous tick's state, 1 = the latest
+    static float alpha;
     static void updateTime();
+    // seconds since the last call (capped), what updateTime() advances by
+    static float clockDelta();
+    // forgets the accumulated time, for starting a replay from a clean slate
+    static void reset();
+    // what updateTime() does with the clock's delta, for callers with their own clock
+    static void advance(float frameDelta);
+    static void setTickRate(float ticksPerSecond);
+    static bool beginTick();
 private:
-
+    static float accumulator_;
 };
 #endif //SPACEINVADERS3D_TIME_H
 
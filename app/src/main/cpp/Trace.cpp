@@ -0,0 +1,117 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "Trace.h"
+#include "GameObjectData.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Only the owning thread writes events, it publishes them by bumping count (release) so the
+// exporter can read [0, count) without a lock. The array is allocated on the first record(), a
+// thread that only got named (or never traced) costs a few bytes instead of 1.5 MB
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::string name;
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> dropped{0};
+};
+
+// buffers stay registered after their thread exits (pipeline workers are short lived)
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+const auto traceEpoch = std::chrono::steady_clock::now();
+
+ThreadBuffer &threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto created = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        created->tid = static_cast<uint32_t>(registry.size()) + 1;
+        registry.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+}
+
+std::atomic<bool> Trace::enabled_{false};
+
+uint64_t Trace::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+void Trace::record(const char *name, uint64_t startNs, uint64_t endNs) {
+    ThreadBuffer &buffer = threadBuffer();
+    uint32_t index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= MAX_EVENTS_PER_THREAD) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!buffer.events) buffer.events.reset(new TraceEvent[MAX_EVENTS_PER_THREAD]);
+    buffer.events[index] = {name, startNs, endNs};
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const char *name) {
+    ThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.name = name;
+}
+
+bool Trace::writeJson(const std::string &path) {
+    std::ofstream out(path);
+    if (!out) {
+        LOGE("Couldn't open trace file %s", path.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    uint32_t eventCount = 0, droppedCount = 0;
+    bool first = true;
+    auto separator = [&]() -> std::ofstream & {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        return out;
+    };
+
+    // complete ("X") events, timestamps are in microseconds
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char line[256];
+    for (const auto &buffer: registry) {
+        if (!buffer->name.empty()) {
+            separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                        << buffer->tid << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+        }
+        uint32_t count = buffer->count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; ++i) {
+            const TraceEvent &event = buffer->events[i];
+            snprintf(line, sizeof(line),
+                     "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     event.name, buffer->tid, event.startNs / 1000.0,
+                     (event.endNs - event.startNs) / 1000.0);
+            separator() << line;
+        }
+        eventCount += count;
+        droppedCount += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    out << "\n]}\n";
+
+    LOGE("Wrote %u trace events to %s (%u dropped)", eventCount, path.c_str(), droppedCount);
+    return out.good();
+}
@@ -0,0 +1,74 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_TRACE_H
+#define SPACEINVADERS3D_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped CPU zones written to per-thread buffers and exported as Chrome trace JSON, which
+// chrome://tracing and ui.perfetto.dev both open. Off by default, a disabled zone is one relaxed
+// atomic load. Build with SPACEINVADERS3D_NO_TRACE to compile the zones out completely.
+//
+//     TRACE_SCOPE("loadTexture");
+//
+// Zone names must be string literals (or otherwise outlive the trace), only the pointer is kept.
+class Trace {
+public:
+    // per thread, zones past this are dropped and counted
+    static constexpr uint32_t MAX_EVENTS_PER_THREAD = 1 << 16;
+
+    class Zone {
+    public:
+        explicit Zone(const char *name) {
+            if (enabled_.load(std::memory_order_relaxed)) {
+                name_ = name;
+                startNs_ = nowNs();
+            }
+        }
+
+        ~Zone() {
+            if (name_) record(name_, startNs_, nowNs());
+        }
+
+        Zone(const Zone &) = delete;
+
+        Zone &operator=(const Zone &) = delete;
+
+    private:
+        const char *name_ = nullptr;
+        uint64_t startNs_ = 0;
+    };
+
+    static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // names the calling thread in the exported trace
+    static void setThreadName(const char *name);
+
+    // Everything recorded so far, from every thread. Threads may keep recording while this runs,
+    // their newer zones just end up in the next export
+    static bool writeJson(const std::string &path);
+
+private:
+    static std::atomic<bool> enabled_;
+
+    static uint64_t nowNs();
+
+    static void record(const char *name, uint64_t startNs, uint64_t endNs);
+};
+
+#ifdef SPACEINVADERS3D_NO_TRACE
+#define TRACE_SCOPE(name)
+#else
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Trace::Zone TRACE_CONCAT(traceZone_, __LINE__)(name)
+#endif
+
+
+#endif //SPACEINVADERS3D_TRACE_H
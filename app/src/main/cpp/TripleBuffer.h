@@ -0,0 +1,58 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_TRIPLEBUFFER_H
+#define SPACEINVADERS3D_TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer hand-off of the newest T. The producer fills writeSlot() and
+// publish()es it, the consumer acquire()s and reads readSlot(). The third slot sits in between
+// and the two sides only ever swap indices with it through one atomic, so neither side waits on
+// the other and a slot is never touched by both at once. Slots are reused, not reallocated, so
+// vectors inside T keep their capacity between frames.
+template<typename T>
+class TripleBuffer {
+public:
+    // producer side
+    T &writeSlot() { return slots_[write_]; }
+
+    // hands writeSlot() over and gets a fresh slot to write into. If the consumer didn't take the
+    // last published one it's overwritten
+    void publish() {
+        uint32_t previous = middle_.exchange(write_ | FRESH_BIT, std::memory_order_acq_rel);
+        write_ = previous & INDEX_MASK;
+    }
+
+    // something published since the last acquire(), callable from either side
+    bool hasFresh() const { return (middle_.load(std::memory_order_acquire) & FRESH_BIT) != 0; }
+
+    // consumer side, false (and readSlot() unchanged) if nothing new was published
+    bool acquire() {
+        if (!hasFresh()) return false;
+        uint32_t previous = middle_.exchange(read_, std::memory_order_acq_rel);
+        read_ = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T &readSlot() const { return slots_[read_]; }
+
+    // every slot, for setting them up before either side starts
+    T &slot(uint32_t index) { return slots_[index]; }
+
+    static constexpr uint32_t SLOT_COUNT = 3;
+
+private:
+    static constexpr uint32_t FRESH_BIT = 4;
+    static constexpr uint32_t INDEX_MASK = 3;
+
+    T slots_[SLOT_COUNT];
+    uint32_t write_ = 0;
+    uint32_t read_ = 1;
+    std::atomic<uint32_t> middle_{2};
+};
+
+
+#endif //SPACEINVADERS3D_TRIPLEBUFFER_H
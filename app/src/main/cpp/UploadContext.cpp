@@ -0,0 +1,314 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "UploadContext.h"
+#include "Trace.h"
+#include <stdexcept>
+
+// enough for RGBA8 texel copies and anything we bind as vertex/index data
+static const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+// stages that read uploaded data, also what the ownership acquire waits at
+static const VkPipelineStageFlags CONSUMER_STAGES =
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+UploadContext::UploadContext(VkDevice device, MemoryAllocator &allocator,
+                             uint32_t graphicsQueueFamily, VkQueue graphicsQueue,
+                             uint32_t transferQueueFamily, VkQueue transferQueue,
+                             VkExtent3D imageGranularity, VkDeviceSize stagingChunkSize)
+        : device_(device), allocator_(allocator), graphicsQueueFamily_(graphicsQueueFamily),
+          graphicsQueue_(graphicsQueue), transferQueueFamily_(transferQueueFamily),
+          transferQueue_(transferQueue), imageGranularity_(imageGranularity),
+          stagingChunkSize_(stagingChunkSize) {
+    transferPool_ = createPool(transferQueueFamily_);
+    if (usesTransferQueue())
+        graphicsPool_ = createPool(graphicsQueueFamily_);
+    LOGE("Uploads go through the %s queue (family %u)",
+         usesTransferQueue() ? "transfer" : "graphics", transferQueueFamily_);
+}
+
+UploadContext::~UploadContext() {
+    wait();
+    // queued but never submitted
+    for (auto &chunk: chunks_) {
+        vkDestroyBuffer(device_, chunk.buffer, nullptr);
+        allocator_.free(chunk.memory);
+    }
+    vkDestroyCommandPool(device_, transferPool_, nullptr);
+    if (graphicsPool_ != VK_NULL_HANDLE)
+        vkDestroyCommandPool(device_, graphicsPool_, nullptr);
+}
+
+VkCommandPool UploadContext::createPool(uint32_t queueFamily) {
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    VkCommandPool pool;
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        LOGE("Failed to create upload command pool for family %u", queueFamily);
+        throw std::runtime_error("Failed to create upload command pool");
+    }
+    return pool;
+}
+
+VkCommandBuffer UploadContext::beginCommandBuffer(VkCommandPool pool) {
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer cmd;
+    vkAllocateCommandBuffers(device_, &allocInfo, &cmd);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &beginInfo);
+    return cmd;
+}
+
+UploadContext::Staging UploadContext::allocateStaging(VkDeviceSize size) {
+    if (size == 0) return {};
+
+    Chunk *chunk = chunks_.empty() ? nullptr : &chunks_.back();
+    VkDeviceSize offset = chunk ? (chunk->head + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1)
+                                : 0;
+    if (!chunk || offset + size > chunk->memory.size) {
+        // textures bigger than a chunk just get a chunk of their own
+        Chunk newChunk;
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = std::max(stagingChunkSize_, size);
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device_, &bufferInfo, nullptr, &newChunk.buffer) != VK_SUCCESS) {
+            LOGE("Failed to create staging buffer");
+            throw std::runtime_error("Failed to create staging buffer");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device_, newChunk.buffer, &memRequirements);
+        newChunk.memory = allocator_.allocate(memRequirements,
+                                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true);
+        vkBindBufferMemory(device_, newChunk.buffer, newChunk.memory.memory,
+                           newChunk.memory.offset);
+
+        chunks_.push_back(newChunk);
+        chunk = &chunks_.back();
+        offset = 0;
+    }
+
+    chunk->head = offset + size;
+    return {static_cast<uint8_t *>(chunk->memory.mapped) + offset, chunk->buffer, offset, size};
+}
+
+void UploadContext::uploadImage(VkImage image, uint32_t width, uint32_t height,
+                                const Staging &src, uint32_t layer) {
+    imageCopies_.push_back({image, width, height, layer, src});
+}
+
+void UploadContext::uploadBuffer(VkBuffer dst, const Staging &src) {
+    bufferCopies_.push_back({dst, src});
+}
+
+void UploadContext::submit() {
+    if (imageCopies_.empty() && bufferCopies_.empty()) return;
+    TRACE_SCOPE("UploadContext::submit");
+
+    Batch batch;
+    batch.transferCmd = beginCommandBuffer(transferPool_);
+    VkCommandBuffer cmd = batch.transferCmd;
+
+    std::vector<VkImageMemoryBarrier> imageBarriers(imageCopies_.size());
+    for (size_t i = 0; i < imageCopies_.size(); ++i) {
+        VkImageMemoryBarrier &barrier = imageBarriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = imageCopies_[i].image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, imageCopies_[i].layer,
+                                    1};
+    }
+    if (!imageBarriers.empty()) {
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                             static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    for (const auto &copy: imageCopies_) {
+        VkBufferImageCopy region = {};
+        region.bufferOffset = copy.src.offset;
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, copy.layer, 1};
+        region.imageExtent = {copy.width, copy.height, 1};
+        vkCmdCopyBufferToImage(cmd, copy.src.buffer, copy.image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+    for (const auto &copy: bufferCopies_) {
+        VkBufferCopy region = {copy.src.offset, 0, copy.src.size};
+        vkCmdCopyBuffer(cmd, copy.src.buffer, copy.buffer, 1, &region);
+    }
+
+    // same barriers either way, on a separate transfer queue they become the ownership release
+    // (the matching acquire is recorded by recordAcquire)
+    std::vector<VkBufferMemoryBarrier> bufferBarriers(bufferCopies_.size());
+    for (size_t i = 0; i < imageCopies_.size(); ++i) {
+        VkImageMemoryBarrier &barrier = imageBarriers[i];
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = usesTransferQueue() ? 0 : VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if (usesTransferQueue()) {
+            barrier.srcQueueFamilyIndex = transferQueueFamily_;
+            barrier.dstQueueFamilyIndex = graphicsQueueFamily_;
+        }
+    }
+    for (size_t i = 0; i < bufferCopies_.size(); ++i) {
+        VkBufferMemoryBarrier &barrier = bufferBarriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = usesTransferQueue() ? 0 : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                                                          VK_ACCESS_INDEX_READ_BIT;
+        barrier.srcQueueFamilyIndex = usesTransferQueue() ? transferQueueFamily_
+                                                          : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = usesTransferQueue() ? graphicsQueueFamily_
+                                                          : VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = bufferCopies_[i].buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+    }
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         usesTransferQueue() ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+                                             : CONSUMER_STAGES,
+                         0, 0, nullptr,
+                         static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                         static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    vkEndCommandBuffer(cmd);
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    vkCreateFence(device_, &fenceInfo, nullptr, &batch.fence);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.transferCmd;
+
+    if (!usesTransferQueue()) {
+        // later frames go to the same queue, the barriers above already order them after the copies
+        if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+            LOGE("Failed to submit upload batch");
+            throw std::runtime_error("Failed to submit upload batch");
+        }
+    } else {
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &batch.transferDone);
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &batch.transferDone;
+        if (vkQueueSubmit(transferQueue_, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            LOGE("Failed to submit upload batch to the transfer queue");
+            throw std::runtime_error("Failed to submit upload batch");
+        }
+
+        // the graphics queue picks the resources up before any frame submitted after this uses them
+        batch.acquireCmd = beginCommandBuffer(graphicsPool_);
+        recordAcquire(batch.acquireCmd);
+        vkEndCommandBuffer(batch.acquireCmd);
+
+        VkPipelineStageFlags waitStage = CONSUMER_STAGES;
+        VkSubmitInfo acquireInfo = {};
+        acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireInfo.waitSemaphoreCount = 1;
+        acquireInfo.pWaitSemaphores = &batch.transferDone;
+        acquireInfo.pWaitDstStageMask = &waitStage;
+        acquireInfo.commandBufferCount = 1;
+        acquireInfo.pCommandBuffers = &batch.acquireCmd;
+        if (vkQueueSubmit(graphicsQueue_, 1, &acquireInfo, batch.fence) != VK_SUCCESS) {
+            LOGE("Failed to submit upload ownership acquire");
+            throw std::runtime_error("Failed to submit upload batch");
+        }
+    }
+
+    LOGE("Upload batch submitted: %zu images, %zu buffers, %zu staging chunks",
+         imageCopies_.size(), bufferCopies_.size(), chunks_.size());
+    batch.chunks = std::move(chunks_);
+    chunks_.clear();
+    imageCopies_.clear();
+    bufferCopies_.clear();
+    inFlight_.push_back(std::move(batch));
+}
+
+void UploadContext::recordAcquire(VkCommandBuffer cmd) {
+    std::vector<VkImageMemoryBarrier> imageBarriers(imageCopies_.size());
+    for (size_t i = 0; i < imageCopies_.size(); ++i) {
+        VkImageMemoryBarrier &barrier = imageBarriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        // has to match the release exactly
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcQueueFamilyIndex = transferQueueFamily_;
+        barrier.dstQueueFamilyIndex = graphicsQueueFamily_;
+        barrier.image = imageCopies_[i].image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, imageCopies_[i].layer,
+                                    1};
+    }
+    std::vector<VkBufferMemoryBarrier> bufferBarriers(bufferCopies_.size());
+    for (size_t i = 0; i < bufferCopies_.size(); ++i) {
+        VkBufferMemoryBarrier &barrier = bufferBarriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        barrier.srcQueueFamilyIndex = transferQueueFamily_;
+        barrier.dstQueueFamilyIndex = graphicsQueueFamily_;
+        barrier.buffer = bufferCopies_[i].buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+    }
+    vkCmdPipelineBarrier(cmd, CONSUMER_STAGES, CONSUMER_STAGES, 0, 0, nullptr,
+                         static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                         static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+void UploadContext::release(Batch &batch) {
+    vkDestroyFence(device_, batch.fence, nullptr);
+    if (batch.transferDone != VK_NULL_HANDLE)
+        vkDestroySemaphore(device_, batch.transferDone, nullptr);
+    vkFreeCommandBuffers(device_, transferPool_, 1, &batch.transferCmd);
+    if (batch.acquireCmd != VK_NULL_HANDLE)
+        vkFreeCommandBuffers(device_, graphicsPool_, 1, &batch.acquireCmd);
+    for (auto &chunk: batch.chunks) {
+        vkDestroyBuffer(device_, chunk.buffer, nullptr);
+        allocator_.free(chunk.memory);
+    }
+}
+
+bool UploadContext::poll() {
+    for (size_t i = 0; i < inFlight_.size();) {
+        if (vkGetFenceStatus(device_, inFlight_[i].fence) == VK_SUCCESS) {
+            release(inFlight_[i]);
+            inFlight_.erase(inFlight_.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+    return inFlight_.empty();
+}
+
+void UploadContext::wait() {
+    for (auto &batch: inFlight_) {
+        vkWaitForFences(device_, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        release(batch);
+    }
+    inFlight_.clear();
+}
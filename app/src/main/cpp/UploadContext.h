@@ -0,0 +1,118 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_UPLOADCONTEXT_H
+#define SPACEINVADERS3D_UPLOADCONTEXT_H
+
+#include "GameObjectData.h"
+#include "MemoryAllocator.h"
+
+// Batches static uploads (textures, vertex/index data) into one submission instead of a
+// one-shot command buffer + vkQueueWaitIdle per transition/copy.
+// Callers grab a piece of the mapped staging arena, write their data straight into it, then queue
+// the copy with uploadImage/uploadBuffer. submit() records every barrier and copy of the batch into
+// a single command buffer and returns without waiting; poll() releases the staging memory once the
+// batch's fence has signalled. If the device has a transfer-only queue family the copies run there
+// and ownership is handed over to the graphics family.
+class UploadContext {
+public:
+    struct Staging {
+        void *data{nullptr};
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};
+        VkDeviceSize size{0};
+
+        bool valid() const { return data != nullptr; }
+    };
+
+    UploadContext(VkDevice device, MemoryAllocator &allocator, uint32_t graphicsQueueFamily,
+                  VkQueue graphicsQueue, uint32_t transferQueueFamily, VkQueue transferQueue,
+                  VkExtent3D imageGranularity, VkDeviceSize stagingChunkSize = 4 * 1024 * 1024);
+
+    ~UploadContext();
+
+    // bump allocated from the current batch's staging chunks, valid until submit()
+    Staging allocateStaging(VkDeviceSize size);
+
+    // image layer must be freshly created (UNDEFINED), ends up SHADER_READ_ONLY_OPTIMAL.
+    // width/height can be smaller than the image, the copy goes to the top left corner. It then
+    // has to be a multiple of imageGranularity() unless it reaches the image's edge anyway
+    void uploadImage(VkImage image, uint32_t width, uint32_t height, const Staging &src,
+                     uint32_t layer = 0);
+
+    // dst must have TRANSFER_DST usage, readable as vertex/index data once the batch lands
+    void uploadBuffer(VkBuffer dst, const Staging &src);
+
+    // records and submits everything queued so far, doesn't block
+    void submit();
+
+    // frees staging of finished batches, returns true when nothing is pending anymore
+    bool poll();
+
+    // blocks until every submitted batch has finished (shutdown/restart)
+    void wait();
+
+    bool usesTransferQueue() const { return transferQueueFamily_ != graphicsQueueFamily_; }
+
+    // minImageTransferGranularity of the queue the copies run on, 0 = whole images only
+    VkExtent3D imageGranularity() const { return imageGranularity_; }
+
+    uint32_t pendingBatches() const { return static_cast<uint32_t>(inFlight_.size()); }
+
+private:
+    struct Chunk {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        MemoryAllocation memory;
+        VkDeviceSize head{0};
+    };
+
+    struct ImageCopy {
+        VkImage image;
+        uint32_t width;
+        uint32_t height;
+        uint32_t layer;
+        Staging src;
+    };
+
+    struct BufferCopy {
+        VkBuffer buffer;
+        Staging src;
+    };
+
+    struct Batch {
+        VkFence fence{VK_NULL_HANDLE};
+        VkSemaphore transferDone{VK_NULL_HANDLE};
+        VkCommandBuffer transferCmd{VK_NULL_HANDLE};
+        VkCommandBuffer acquireCmd{VK_NULL_HANDLE};
+        std::vector<Chunk> chunks;
+    };
+
+    VkDevice device_{VK_NULL_HANDLE};
+    MemoryAllocator &allocator_;
+    uint32_t graphicsQueueFamily_;
+    VkQueue graphicsQueue_;
+    uint32_t transferQueueFamily_;
+    VkQueue transferQueue_;
+    VkExtent3D imageGranularity_;
+    VkDeviceSize stagingChunkSize_;
+
+    VkCommandPool transferPool_{VK_NULL_HANDLE};
+    VkCommandPool graphicsPool_{VK_NULL_HANDLE}; // only for the ownership acquire
+
+    std::vector<Chunk> chunks_;
+    std::vector<ImageCopy> imageCopies_;
+    std::vector<BufferCopy> bufferCopies_;
+    std::vector<Batch> inFlight_;
+
+    VkCommandPool createPool(uint32_t queueFamily);
+
+    VkCommandBuffer beginCommandBuffer(VkCommandPool pool);
+
+    void recordAcquire(VkCommandBuffer cmd);
+
+    void release(Batch &batch);
+};
+
+
+#endif //SPACEINVADERS3D_UPLOADCONTEXT_H
@@ -0,0 +1,52 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#include "UploadRing.h"
+#include <stdexcept>
+
+UploadRing::UploadRing(VkDevice device, MemoryAllocator &allocator, VkBuffer buffer,
+                       MemoryAllocation memory, VkDeviceSize frameSize, uint32_t frameCount,
+                       VkDeviceSize alignment)
+        : device_(device), allocator_(allocator), buffer_(buffer), memory_(memory),
+          frameCount_(frameCount), alignment_(alignment) {
+    // keep every slice aligned too so offsets stay valid for any binding type
+    frameSize_ = (frameSize + alignment_ - 1) & ~(alignment_ - 1);
+
+    if (!memory_.mapped) {
+        LOGE("Upload ring memory isn't host visible");
+        throw std::runtime_error("Upload ring memory isn't host visible");
+    }
+    mapped_ = static_cast<uint8_t *>(memory_.mapped);
+}
+
+UploadRing::~UploadRing() {
+    vkDestroyBuffer(device_, buffer_, nullptr);
+    allocator_.free(memory_);
+}
+
+void UploadRing::beginFrame(uint32_t frameIndex) {
+    frameBegin_ = frameSize_ * (frameIndex % frameCount_);
+    head_ = frameBegin_;
+}
+
+UploadRing::Allocation UploadRing::allocate(VkDeviceSize size) {
+    VkDeviceSize offset = (head_ + alignment_ - 1) & ~(alignment_ - 1);
+    if (size == 0 || offset + size > frameBegin_ + frameSize_) {
+        if (size != 0 && !overflowLogged_) {
+            LOGE("Upload ring full: %llu bytes requested, %llu of %llu used this frame",
+                 (unsigned long long) size, (unsigned long long) usedThisFrame(),
+                 (unsigned long long) frameSize_);
+            overflowLogged_ = true;
+        }
+        return {};
+    }
+    head_ = offset + size;
+    return {mapped_ + offset, buffer_, offset, size};
+}
+
+UploadRing::Allocation UploadRing::push(const void *src, VkDeviceSize size) {
+    Allocation allocation = allocate(size);
+    if (allocation.valid()) memcpy(allocation.data, src, size);
+    return allocation;
+}
@@ -0,0 +1,60 @@
+//
+// Created by carlo on 17/10/2026.
+//
+
+#ifndef SPACEINVADERS3D_UPLOADRING_H
+#define SPACEINVADERS3D_UPLOADRING_H
+
+#include "GameObjectData.h"
+#include "MemoryAllocator.h"
+
+// One host visible buffer, mapped for its whole life, split into a slice per frame in flight.
+// Everything the CPU rewrites each frame (instances, text, debug boxes...) is bump allocated from
+// the current frame's slice and bound with buffer + offset, so there's no map/unmap per upload
+// and a frame never writes into memory the GPU may still be reading for an older frame.
+class UploadRing {
+public:
+    struct Allocation {
+        void *data{nullptr};
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};
+        VkDeviceSize size{0};
+
+        bool valid() const { return data != nullptr; }
+    };
+
+    // takes ownership of buffer/memory, memory must be HOST_VISIBLE | HOST_COHERENT (and so mapped)
+    UploadRing(VkDevice device, MemoryAllocator &allocator, VkBuffer buffer,
+               MemoryAllocation memory, VkDeviceSize frameSize, uint32_t frameCount,
+               VkDeviceSize alignment);
+
+    ~UploadRing();
+
+    // call after the frame's fence has been waited on, resets that frame's slice
+    void beginFrame(uint32_t frameIndex);
+
+    // returns an invalid allocation if the frame's slice is full, caller just skips the draw
+    Allocation allocate(VkDeviceSize size);
+
+    Allocation push(const void *src, VkDeviceSize size);
+
+    VkDeviceSize frameSize() const { return frameSize_; }
+
+    VkDeviceSize usedThisFrame() const { return head_ - frameBegin_; }
+
+private:
+    VkDevice device_{VK_NULL_HANDLE};
+    MemoryAllocator &allocator_;
+    VkBuffer buffer_{VK_NULL_HANDLE};
+    MemoryAllocation memory_;
+    uint8_t *mapped_{nullptr};
+    VkDeviceSize frameSize_{0};
+    uint32_t frameCount_{0};
+    VkDeviceSize alignment_{16};
+    VkDeviceSize frameBegin_{0};
+    VkDeviceSize head_{0};
+    bool overflowLogged_ = false;
+};
+
+
+#endif //SPACEINVADERS3D_UPLOADRING_H
@@ -18,7 +18,8 @@ Util::getQuadWidthHeight(const Vertex *verts, size_t vertsCount,std::array<float
     return {(maxX - minX) * sizeXY[0], (maxY - minY) * sizeXY[1]};
 }
 
-void Util::recordDrawBoundingBox(VkCommandBuffer cmd, const AABB &box, const glm::vec3 &color) {
+void Util::recordDrawBoundingBox(VkCommandBuffer cmd, UploadRing &uploadRing, const AABB &box,
+                                 const glm::vec3 &color) {
     Vertex verts[5] = {
             {{box.minX, box.minY}, {color.r, color.g, color.b}},
             {{box.maxX, box.minY}, {color.r, color.g, color.b}},
@@ -27,29 +28,36 @@ void Util::recordDrawBoundingBox(VkCommandBuffer cmd, const AABB &box, const glm
             {{box.minX, box.minY}, {color.r, color.g, color.b}} // close loop
     };
 
-    void *mapped;
-    vkMapMemory(device, stagingBufferMemory, 0, sizeof(verts), 0, &mapped);
-    memcpy(mapped, verts, sizeof(verts));
-    vkUnmapMemory(device, stagingBufferMemory);
+    // each box gets its own bit of the ring, so several boxes per frame don't stomp each other
+    UploadRing::Allocation vertices = uploadRing.push(verts, sizeof(verts));
+    if (!vertices.valid()) return;
 
-    // Assuming vtxBuffer is ready and contains verts...
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, aabbPipeline);
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmd, 0, 1, &vtxBuffer, offsets);
+    VkDeviceSize offsets[] = {vertices.offset};
+    vkCmdBindVertexBuffers(cmd, 0, 1, &vertices.buffer, offsets);
     vkCmdDraw(cmd, 5, 1, 0, 0); // 5 vertices, 1 instance
 
 }
 
+// Straight from the generator instead of std::uniform_*_distribution: mt19937's output is fixed
+// by the standard, the distributions aren't, and a replay recorded against libc++ has to play
+// back the same on libstdc++.
+
 // returns random unsigned int between min and max
 uint Util::getRandomUint(uint32_t min, uint32_t max) {
-    std::uniform_int_distribution<uint32_t> x(min, max);
-    return x(rng);
+    uint64_t span = uint64_t(max) - min + 1;
+    return min + uint32_t(rng() % span);
 }
 
 // returns random float between min and max
 float Util::getRandomFloat(float min, float max) {
-    std::uniform_real_distribution<float> x(min, max);
-    return x(rng);
+    // top 24 bits, exactly representable, so [0, 1)
+    float unit = float(rng() >> 8) * (1.0f / 16777216.0f);
+    return min + (max - min) * unit;
+}
+
+void Util::seed(uint32_t seed) {
+    rng.seed(seed);
 }
 
 std::mt19937 Util::rng{std::random_device{}()};
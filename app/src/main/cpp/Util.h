@@ -6,21 +6,22 @@
 #define SPACEINVADERS3D_UTIL_H
 #include "GameObjectData.h"
 #include "Collision.h"
+#include "UploadRing.h"
 
 class Util {
 private:
     static std::mt19937 rng;
 public:
     VkDevice device;
-    VkBuffer vtxBuffer{VK_NULL_HANDLE};
-    VkDeviceMemory stagingBufferMemory{VK_NULL_HANDLE};
     VkPipeline aabbPipeline{VK_NULL_HANDLE};
     VkPipelineLayout aabbPipelineLayout{VK_NULL_HANDLE};
     static std::array<float,2> getQuadWidthHeight(const Vertex *verts, size_t vertsCount,std::array<float,2> sizeXY);
     static uint32_t getRandomUint(uint32_t min, uint32_t max);
     static float getRandomFloat(float min, float max);
+    // gameplay randomness all comes from here, so seeding it makes a session repeatable (Replay)
+    static void seed(uint32_t seed);
 
-    void recordDrawBoundingBox(VkCommandBuffer cmd, const AABB& box, const glm::vec3& color);
+    void recordDrawBoundingBox(VkCommandBuffer cmd, UploadRing &uploadRing, const AABB& box, const glm::vec3& color);
 };
 
 
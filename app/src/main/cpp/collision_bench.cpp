@@ -0,0 +1,184 @@
+//
+// Created by carlo on 17/10/2026.
+//
+// Checks that Collision::isCollidingBatch agrees bit for bit with the scalar path (touching
+// edges and NaNs included) and times both, plus a pair at a time isColliding() loop. Also checks
+// that swept bullets never tunnel through a target at big time steps.
+// Exits with 1 on any failed check.
+//
+
+#include "Collision.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+static AABBArray randomBoxes(std::mt19937 &rng, uint32_t count) {
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> extent(0.0f, 0.1f);
+    AABBArray boxes;
+    for (uint32_t i = 0; i < count; ++i) {
+        float x = position(rng), y = position(rng);
+        boxes.push({x, y, x + extent(rng), y + extent(rng)});
+    }
+    return boxes;
+}
+
+static bool checkAgreement() {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> coin(0, 15);
+    std::vector<uint64_t> simd, scalar;
+    for (uint32_t count = 0; count < 300; ++count) {
+        AABBArray boxes = randomBoxes(rng, count);
+        AABB query = {-0.3f, -0.3f, 0.3f, 0.3f};
+        // make some boxes touch the query exactly, and poison a few with NaNs
+        for (uint32_t i = 0; i < count; ++i) {
+            int c = coin(rng);
+            if (c == 0) boxes.maxX[i] = query.minX;
+            if (c == 1) boxes.minY[i] = query.maxY;
+            if (c == 2) boxes.minX[i] = NAN;
+        }
+        if (count % 7 == 0) query.maxY = NAN;
+
+        simd.assign((count + 63) / 64 + 1, ~0ull);
+        scalar.assign((count + 63) / 64 + 1, ~0ull);
+        Collision::isCollidingBatch(query, boxes.batch(0, count), simd.data());
+        Collision::isCollidingBatchScalar(query, boxes.batch(0, count), scalar.data());
+        if (simd != scalar) {
+            printf("mismatch at count %u\n", count);
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            AABB box = {boxes.minX[i], boxes.minY[i], boxes.maxX[i], boxes.maxY[i]};
+            bool bit = (scalar[i / 64] >> (i % 64)) & 1;
+            if (bit != Collision::isColliding(query, box)) {
+                printf("scalar batch disagrees with isColliding at %u/%u\n", i, count);
+                return false;
+            }
+        }
+        std::vector<uint32_t> hits(count);
+        uint32_t hitCount = Collision::collidingIndices(query, boxes.batch(0, count), hits.data());
+        uint32_t expected = 0;
+        for (uint64_t word: scalar) expected += __builtin_popcountll(word);
+        // the padding word was filled with ~0 and must come back untouched
+        expected -= __builtin_popcountll(scalar.back());
+        if (hitCount != expected) {
+            printf("collidingIndices found %u hits, expected %u\n", hitCount, expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+// a bullet at the game's 2 NDC/s against a thin target sliding sideways, like an alien row.
+// Testing overlap once per step misses it more and more as the step grows, the swept test has to
+// catch every single one
+static bool checkNoTunneling() {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> offset(0.0f, 1.0f);
+    const float bulletSpeed = 2.0f, targetSpeed = 0.3f;
+    const AABB target = {-0.05f, 0.5f, 0.05f, 0.54f};
+    printf("%10s %16s %16s\n", "step s", "discrete misses", "swept misses");
+    for (float dt: {1.0f / 60.0f, 1.0f / 30.0f, 1.0f / 15.0f, 0.1f, 0.25f}) {
+        const int runs = 1000;
+        int discreteMisses = 0, sweptMisses = 0;
+        for (int run = 0; run < runs; ++run) {
+            // start somewhere below the target, lined up with where the target will be when
+            // the bullet gets there, so a continuous path always hits
+            float y = -0.5f - offset(rng) * 0.5f;
+            float arrival = (target.minY - y) / bulletSpeed;
+            float x = targetSpeed * arrival - 0.03f + offset(rng) * 0.06f;
+            float targetX = 0.0f;
+            bool discreteHit = false, sweptHit = false;
+            for (int step = 0; step < 100 && y < 1.0f; ++step) {
+                AABB bullet = Collision::getAABB(x, y, 0.01f, 0.03f);
+                float bulletMove = bulletSpeed * dt;
+                float targetMove = targetSpeed * dt;
+                y += bulletMove;
+                targetX += targetMove;
+                AABB movedTarget = {target.minX + targetX, target.minY, target.maxX + targetX,
+                                    target.maxY};
+
+                // relative motion: the target's step is taken out of the bullet's
+                AABB start = {bullet.minX + targetMove, bullet.minY, bullet.maxX + targetMove,
+                              bullet.maxY};
+                float timeOfImpact;
+                if (Collision::sweep(start, -targetMove, bulletMove, movedTarget, timeOfImpact))
+                    sweptHit = true;
+                if (Collision::isColliding(Collision::getAABB(x, y, 0.01f, 0.03f), movedTarget))
+                    discreteHit = true;
+                if (sweptHit && discreteHit) break;
+            }
+            discreteMisses += !discreteHit;
+            sweptMisses += !sweptHit;
+        }
+        printf("%10.4f %16d %16d\n", dt, discreteMisses, sweptMisses);
+        if (sweptMisses) return false;
+    }
+
+    // no displacement has to be exactly the static test
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    for (int i = 0; i < 100000; ++i) {
+        float ax = position(rng), ay = position(rng), bx = position(rng), by = position(rng);
+        AABB a = {ax, ay, ax + offset(rng), ay + offset(rng)};
+        AABB b = {bx, by, bx + offset(rng), by + offset(rng)};
+        float timeOfImpact = -1.0f;
+        if (Collision::sweep(a, 0.0f, 0.0f, b, timeOfImpact) != Collision::isColliding(a, b) ||
+            (Collision::isColliding(a, b) && timeOfImpact != 0.0f)) {
+            printf("static sweep disagrees with isColliding\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Fn>
+static double nsPerBox(uint32_t count, uint32_t queries, Fn &&fn) {
+    auto start = Clock::now();
+    for (uint32_t q = 0; q < queries; ++q) fn(q);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return ns / (double(count) * queries);
+}
+
+int main() {
+    if (!checkAgreement()) return 1;
+    printf("batch and scalar paths agree\n");
+    if (!checkNoTunneling()) return 1;
+    printf("swept test never tunnels\n");
+
+    std::mt19937 rng(7);
+    printf("%8s %14s %14s %14s\n", "boxes", "pairwise ns", "scalar ns", "batch ns");
+    for (uint32_t count: {64u, 1024u, 16384u}) {
+        AABBArray boxes = randomBoxes(rng, count);
+        AABBArray queries = randomBoxes(rng, 256);
+        std::vector<AABB> aos(count);
+        for (uint32_t i = 0; i < count; ++i)
+            aos[i] = {boxes.minX[i], boxes.minY[i], boxes.maxX[i], boxes.maxY[i]};
+        std::vector<uint64_t> mask((count + 63) / 64);
+        uint32_t queryCount = std::max(1u, 4000000u / count);
+        volatile uint64_t sink = 0;
+
+        auto query = [&](uint32_t q) {
+            uint32_t i = q % 256;
+            return AABB{queries.minX[i], queries.minY[i], queries.maxX[i], queries.maxY[i]};
+        };
+        double pairwise = nsPerBox(count, queryCount, [&](uint32_t q) {
+            AABB box = query(q);
+            uint64_t hits = 0;
+            for (const AABB &other: aos) hits += Collision::isColliding(box, other);
+            sink = sink + hits;
+        });
+        double scalar = nsPerBox(count, queryCount, [&](uint32_t q) {
+            Collision::isCollidingBatchScalar(query(q), boxes.batch(0, count), mask.data());
+            sink = sink + mask[0];
+        });
+        double batch = nsPerBox(count, queryCount, [&](uint32_t q) {
+            Collision::isCollidingBatch(query(q), boxes.batch(0, count), mask.data());
+            sink = sink + mask[0];
+        });
+        printf("%8u %14.3f %14.3f %14.3f\n", count, pairwise, scalar, batch);
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+//
+// Created by carlo on 17/10/2026.
+//
+// Desktop entry point: runs the game offscreen for a fixed number of frames so rendering and
+// gameplay can be timed (and dumped) without a phone. Works with any Vulkan ICD incl. lavapipe.
+//
+
+#include "Renderer.h"
+#include "Replay.h"
+#include "Time.h"
+#include "Trace.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+struct HeadlessOptions {
+    std::string assetDir = "app/src/main/assets";
+    uint32_t frames = 600;
+    uint32_t width = 1080;
+    uint32_t height = 2340;
+    uint32_t framesInFlight = 2;
+    std::string dumpPath;
+    std::string pipelineCacheDir;
+    std::string tracePath;
+    bool perfHud = false;
+    float frameRate = 60.0f; // simulated display rate, gameplay ticks at Time's tick rate
+    float tickRate = Time::DEFAULT_TICK_RATE;
+    bool renderThread = false;
+    int jobWorkers = -1;     // -1 = JobSystem's default for this machine
+    bool pinWorkers = false;
+    std::string recordPath;  // replay log to write
+    std::string replayPath;  // replay log to play back instead of the fake finger
+    bool replayChecksums = true;
+};
+
+static void printUsage(const char *exe) {
+    fprintf(stderr,
+            "usage: %s [--assets DIR] [--frames N] [--size WxH] [--frames-in-flight N] [--dump out.ppm]\n"
+            "       [--pipeline-cache DIR] [--trace out.json] [--hud 0|1] [--fps N]\n"
+            "       [--tick-rate N] [--render-thread 0|1] [--job-workers N] [--pin-workers 0|1]\n"
+            "       [--record out.bin | --replay in.bin] [--checksums 0|1]\n",
+            exe);
+}
+
+static bool parseArgs(int argc, char **argv, HeadlessOptions &opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (arg == "--assets") {
+            opts.assetDir = value;
+        } else if (arg == "--frames") {
+            opts.frames = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--size") {
+            if (sscanf(value.c_str(), "%ux%u", &opts.width, &opts.height) != 2) return false;
+        } else if (arg == "--frames-in-flight") {
+            opts.framesInFlight = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--dump") {
+            opts.dumpPath = value;
+        } else if (arg == "--pipeline-cache") {
+            opts.pipelineCacheDir = value;
+        } else if (arg == "--trace") {
+            opts.tracePath = value;
+        } else if (arg == "--hud") {
+            opts.perfHud = value == "1";
+        } else if (arg == "--fps") {
+            opts.frameRate = std::strtof(value.c_str(), nullptr);
+        } else if (arg == "--tick-rate") {
+            opts.tickRate = std::strtof(value.c_str(), nullptr);
+        } else if (arg == "--render-thread") {
+            opts.renderThread = value == "1";
+        } else if (arg == "--job-workers") {
+            opts.jobWorkers = int(std::strtol(value.c_str(), nullptr, 10));
+        } else if (arg == "--pin-workers") {
+            opts.pinWorkers = value == "1";
+        } else if (arg == "--record") {
+            opts.recordPath = value;
+        } else if (arg == "--replay") {
+            opts.replayPath = value;
+        } else if (arg == "--checksums") {
+            opts.replayChecksums = value == "1";
+        } else {
+            return false;
+        }
+    }
+    return opts.frames > 0 && opts.width > 0 && opts.height > 0 && opts.frameRate > 0.0f &&
+           opts.tickRate > 0.0f && (opts.recordPath.empty() || opts.replayPath.empty());
+}
+
+static bool writePPM(const std::string &path, const std::vector<uint8_t> &rgba, uint32_t width,
+                     uint32_t height) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    out << "P6\n" << width << " " << height << "\n255\n";
+    for (size_t i = 0; i < size_t(width) * height; ++i) {
+        out.write(reinterpret_cast<const char *>(&rgba[i * 4]), 3);
+    }
+    return out.good();
+}
+
+int main(int argc, char **argv) {
+    HeadlessOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // on before the renderer exists so startup shows up in the trace too
+    Trace::setEnabled(!opts.tracePath.empty());
+
+    try {
+        // fake clock so runs are comparable between machines. A replay brings its own
+        Time::setTickRate(opts.tickRate);
+        // before the renderer, it seeds the generators the renderer seeds from
+        std::unique_ptr<Replay> replay;
+        if (!opts.recordPath.empty()) {
+            replay = std::make_unique<Replay>(ReplayMode::Record, opts.recordPath,
+                                              opts.replayChecksums);
+        } else if (!opts.replayPath.empty()) {
+            replay = std::make_unique<Replay>(ReplayMode::Playback, opts.replayPath);
+        }
+        auto initStart = std::chrono::steady_clock::now();
+        Renderer renderer(opts.assetDir, opts.width, opts.height, opts.framesInFlight,
+                          opts.pipelineCacheDir);
+        printf("init took %.1f ms\n", std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - initStart).count());
+        if (opts.perfHud) renderer.enablePerfHud();
+        if (opts.jobWorkers >= 0 || opts.pinWorkers) {
+            renderer.startJobSystem(opts.jobWorkers >= 0 ? uint32_t(opts.jobWorkers)
+                                                         : JobSystem::defaultWorkerCount(),
+                                    opts.pinWorkers);
+        }
+        if (opts.renderThread) renderer.startRenderThread();
+
+        // input goes through the same path as handle_input, so a recording replays it exactly
+        auto input = [&renderer, &replay](const ReplayEvent &event) {
+            if (replay) replay->recordInput(event);
+            Replay::apply(renderer, event);
+        };
+        bool playing = replay && replay->playing();
+        auto start = std::chrono::steady_clock::now();
+        uint32_t frames = 0;
+        // a playback runs to the end of its log, --frames doesn't apply
+        for (; playing || frames < opts.frames; ++frames) {
+            if (!playing) {
+                if (renderer.gameState != GameState::Playing) {
+                    input({ReplayEventType::Restart});
+                }
+                // fake a finger sweeping across the bottom of the screen
+                input({ReplayEventType::Touch, {std::sin(float(frames) * 0.02f) * 0.8f, 0.9f}});
+            }
+            float frameDelta = 1.0f / opts.frameRate;
+            if (!replay) {
+                Time::advance(frameDelta);
+            } else if (!replay->beginFrame(renderer, frameDelta)) {
+                break;
+            }
+            renderer.drawFrame();
+            if (replay) replay->endFrame(renderer);
+        }
+        // the last frames may still be with the render thread, readPixels() wants them done
+        renderer.stopRenderThread();
+        double totalMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        printf("%u frames in %.1f ms (avg %.3f ms/frame, %u in flight)\n", frames, totalMs,
+               frames ? totalMs / frames : 0.0, opts.framesInFlight);
+        if (renderer.perfHud()) printf("%s", renderer.perfHud()->summary().c_str());
+        if (replay) printf("%s", replay->summary().c_str());
+        if (!opts.tracePath.empty() && !Trace::writeJson(opts.tracePath)) {
+            fprintf(stderr, "Failed to write %s\n", opts.tracePath.c_str());
+            return 1;
+        }
+
+        if (!opts.dumpPath.empty()) {
+            std::vector<uint8_t> pixels;
+            uint32_t width, height;
+            if (!renderer.readPixels(pixels, width, height) ||
+                !writePPM(opts.dumpPath, pixels, width, height)) {
+                fprintf(stderr, "Failed to write %s\n", opts.dumpPath.c_str());
+                return 1;
+            }
+        }
+        // a regression run should fail loudly when the game stopped playing the same
+        if (replay && replay->mismatchCount() > 0) return 1;
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Headless run failed: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+//
+// Created by carlo on 17/10/2026.
+//
+// Checks JobSystem's guarantees (every job of a graph runs once and after its dependencies,
+// parallelFor covers every index exactly once in whole grains, nested parallelFor inside graph
+// jobs) at several worker counts, then times a parallelFor and a frame shaped graph at every
+// worker count up to the core count to show how it scales.
+// Exits with 1 on any failed check. --pin ties the workers to cores.
+//
+
+#include "JobSystem.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// random DAG, records when each job starts and ends on a shared clock
+static bool checkGraph(JobSystem &jobs, std::mt19937 &rng) {
+    const uint32_t jobCount = 200;
+    std::vector<std::vector<uint32_t>> dependencies(jobCount);
+    std::vector<std::atomic<uint32_t>> runs(jobCount);
+    std::vector<uint32_t> started(jobCount), finished(jobCount);
+    std::atomic<uint32_t> clock{0};
+    JobGraph graph;
+    for (int round = 0; round < 20; ++round) {
+        graph.clear();
+        for (uint32_t i = 0; i < jobCount; ++i) {
+            runs[i] = 0;
+            dependencies[i].clear();
+            for (uint32_t tries = 0; i > 0 && tries < 3; ++tries) {
+                uint32_t dependency = rng() % i;
+                if (rng() % 2) dependencies[i].push_back(dependency);
+            }
+        }
+        for (uint32_t i = 0; i < jobCount; ++i) {
+            auto fn = [&, i] {
+                started[i] = clock.fetch_add(1);
+                runs[i].fetch_add(1);
+                finished[i] = clock.fetch_add(1);
+            };
+            // add() only takes an initializer list, the game's graphs are written out by hand
+            const std::vector<uint32_t> &d = dependencies[i];
+            if (d.empty()) graph.add("job", fn);
+            else if (d.size() == 1) graph.add("job", fn, {d[0]});
+            else if (d.size() == 2) graph.add("job", fn, {d[0], d[1]});
+            else graph.add("job", fn, {d[0], d[1], d[2]});
+        }
+        jobs.run(graph);
+        for (uint32_t i = 0; i < jobCount; ++i) {
+            if (runs[i] != 1) {
+                printf("graph job %u ran %u times\n", i, runs[i].load());
+                return false;
+            }
+            for (uint32_t dependency: dependencies[i]) {
+                if (finished[dependency] > started[i]) {
+                    printf("graph job %u started before its dependency %u finished\n", i,
+                           dependency);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool checkParallelFor(JobSystem &jobs, std::mt19937 &rng) {
+    std::vector<std::atomic<uint32_t>> hits(100000);
+    for (int round = 0; round < 200; ++round) {
+        uint32_t begin = rng() % 1000;
+        uint32_t end = begin + rng() % (hits.size() - 1000);
+        uint32_t grain = 1 + rng() % 300;
+        for (auto &hit: hits) hit = 0;
+        std::atomic<bool> misaligned{false};
+        jobs.parallelFor(begin, end, grain, [&](uint32_t first, uint32_t last) {
+            if ((first - begin) % grain != 0 || (last != end && (last - begin) % grain != 0))
+                misaligned = true;
+            for (uint32_t i = first; i < last; ++i) hits[i].fetch_add(1);
+        });
+        if (misaligned) {
+            printf("parallelFor chunk not a whole number of grains (grain %u)\n", grain);
+            return false;
+        }
+        for (uint32_t i = 0; i < hits.size(); ++i) {
+            uint32_t expected = i >= begin && i < end ? 1 : 0;
+            if (hits[i] != expected) {
+                printf("parallelFor [%u, %u) hit %u %u times\n", begin, end, i, hits[i].load());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// graph jobs that split themselves up again, the way a frame's particle job would
+static bool checkNested(JobSystem &jobs) {
+    const uint32_t count = 50000;
+    std::vector<uint32_t> values(count * 4, 0);
+    JobGraph graph;
+    for (int round = 0; round < 20; ++round) {
+        graph.clear();
+        for (uint32_t part = 0; part < 4; ++part) {
+            auto fn = [&jobs, &values, part] {
+                jobs.parallelFor(part * count, (part + 1) * count, 64,
+                                 [&values](uint32_t first, uint32_t last) {
+                                     for (uint32_t i = first; i < last; ++i) values[i]++;
+                                 });
+            };
+            // two independent chains, so nested loops from both run at the same time
+            if (part < 2) graph.add("part", fn);
+            else graph.add("part", fn, {part - 2});
+        }
+        jobs.run(graph);
+    }
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        if (values[i] != 20) {
+            printf("nested parallelFor: element %u updated %u times\n", i, values[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// enough math per element that the loop is compute bound, not memory bound
+static void work(float *data, uint32_t first, uint32_t last) {
+    for (uint32_t i = first; i < last; ++i) {
+        float x = data[i];
+        for (int k = 0; k < 32; ++k) x = std::sin(x) * 0.5f + std::cos(x * 0.25f);
+        data[i] = x;
+    }
+}
+
+static double benchParallelFor(JobSystem &jobs, std::vector<float> &data) {
+    const int frames = 20;
+    auto start = Clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        jobs.parallelFor(0, uint32_t(data.size()), 256, [&data](uint32_t first, uint32_t last) {
+            work(data.data(), first, last);
+        });
+    }
+    return msSince(start) / frames;
+}
+
+// same shape as the game's frame: a serial-ish chain of ticks, then a fan out of independent
+// jobs, a couple of which split up further
+static double benchGraph(JobSystem &jobs, std::vector<float> &data) {
+    const int frames = 20;
+    uint32_t slice = uint32_t(data.size()) / 8;
+    JobGraph graph;
+    auto start = Clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        graph.clear();
+        auto part = [&data, slice](uint32_t index) {
+            return [&data, slice, index] {
+                work(data.data(), index * slice, (index + 1) * slice);
+            };
+        };
+        JobGraph::JobId entities = graph.add("entities", part(0));
+        JobGraph::JobId aliens = graph.add("aliens", part(1));
+        JobGraph::JobId collision = graph.add("collision", part(2), {entities, aliens});
+        graph.add("stars", part(3), {collision});
+        graph.add("halo", part(4), {collision});
+        graph.add("sprites", part(5), {collision});
+        graph.add("particles", [&jobs, &data, slice] {
+            jobs.parallelFor(6 * slice, 8 * slice, 256, [&data](uint32_t first, uint32_t last) {
+                work(data.data(), first, last);
+            });
+        }, {collision});
+        jobs.run(graph);
+    }
+    return msSince(start) / frames;
+}
+
+int main(int argc, char **argv) {
+    bool pin = argc > 1 && strcmp(argv[1], "--pin") == 0;
+    uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<uint32_t> capacities;
+    std::vector<uint32_t> byCapacity = JobSystem::coresByCapacity(&capacities);
+    printf("%u cores", cores);
+    if (!byCapacity.empty()) {
+        printf(", fastest first:");
+        for (uint32_t i = 0; i < byCapacity.size(); ++i)
+            printf(" %u(%u)", byCapacity[i], capacities[i]);
+    }
+    printf("\ndefault worker count %u%s\n", JobSystem::defaultWorkerCount(),
+           pin ? ", workers pinned" : "");
+
+    std::mt19937 rng(42);
+    for (uint32_t workers: {0u, 1u, 3u, 7u}) {
+        JobSystem jobs(workers, pin);
+        if (!checkGraph(jobs, rng) || !checkParallelFor(jobs, rng) || !checkNested(jobs)) {
+            printf("failed with %u workers\n", workers);
+            return 1;
+        }
+    }
+    printf("checks passed\n");
+
+    std::vector<float> data(1 << 17);
+    for (uint32_t i = 0; i < data.size(); ++i) data[i] = float(i % 1000) * 0.001f;
+    printf("%8s %14s %8s %14s %8s %8s\n", "workers", "parallelFor ms", "speedup", "graph ms",
+           "speedup", "steals");
+    double baseFor = 0.0, baseGraph = 0.0;
+    for (uint32_t workers = 0; workers < cores; ++workers) {
+        JobSystem jobs(workers, pin);
+        double forMs = benchParallelFor(jobs, data);
+        double graphMs = benchGraph(jobs, data);
+        if (workers == 0) {
+            baseFor = forMs;
+            baseGraph = graphMs;
+        }
+        printf("%8u %14.3f %7.2fx %14.3f %7.2fx %8llu\n", workers, forMs, baseFor / forMs,
+               graphMs, baseGraph / graphMs, (unsigned long long) jobs.stealCount());
+    }
+    return 0;
+}
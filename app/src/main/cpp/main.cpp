@@ -3,13 +3,16 @@
 #include <android/log.h>
 #include <android/input.h>
 #include "Renderer.h"
+#include "Replay.h"
 #include "Time.h"
+#include <sys/system_properties.h>
 #include <stdexcept>
 
 
 #define LOGI(...) __android_log_print(ANDROID_LOG_ERROR, "Vulkan", __VA_ARGS__)
 Renderer *g_renderer = nullptr; // global pointer
 volatile bool g_pendingRestart = false;
+std::unique_ptr<Replay> g_replay;  // set while recording or playing back a session
 
 void set_ship_x(float x, float y);
 
@@ -25,6 +28,10 @@ static int32_t handle_input(struct android_app *app, AInputEvent *event) {
             // Convert X to normalized device coordinate [-1, 1]
             float ndcX = (x / (float) width) * 2.0f - 1.0f;
             float ndcY = (y / (float) height) * 2.0f - 1.0f;
+            // a replay drives the game on its own, the finger would only desync it
+            if (g_replay && g_replay->playing()) {
+                return 1;
+            }
             if (g_renderer && g_renderer->gameState == GameState::Playing) {
                 // Move ship and fire bullet
                 if (AMotionEvent_getAction(event) == AMOTION_EVENT_ACTION_DOWN ||
@@ -46,9 +53,32 @@ static int32_t handle_input(struct android_app *app, AInputEvent *event) {
 
 void set_ship_x(float x, float y) {
     if (g_renderer) {
-        g_renderer->shipX_ = x;
-        g_renderer->shipY_ = y - 0.12f;
-        g_renderer->spawnBullet(BulletType::Ship, {x, y - 0.12f});
+        ReplayEvent event{ReplayEventType::Touch, {x, y}};
+        if (g_replay) g_replay->recordInput(event);
+        Replay::apply(*g_renderer, event);
+    }
+}
+
+// adb shell setprop debug.spaceinvaders3d.replay record (or play), the log is replay.bin in the
+// app's internal data dir. debug.spaceinvaders3d.replaychecksums 0 records without checksums
+static void startReplay(android_app *app) {
+    char replayProp[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.spaceinvaders3d.replay", replayProp) <= 0 ||
+        !app->activity->internalDataPath)
+        return;
+    std::string mode = replayProp;
+    if (mode != "record" && mode != "play") return;
+    char checksumProp[PROP_VALUE_MAX] = {};
+    bool checksums = __system_property_get("debug.spaceinvaders3d.replaychecksums",
+                                           checksumProp) <= 0 || checksumProp[0] != '0';
+    std::string path = std::string(app->activity->internalDataPath) + "/replay.bin";
+    try {
+        g_replay = std::make_unique<Replay>(mode == "record" ? ReplayMode::Record
+                                                             : ReplayMode::Playback,
+                                            path, checksums);
+    } catch (const std::exception &e) {
+        // play live rather than not at all
+        LOGI("Replay not started: %s", e.what());
     }
 }
 
@@ -102,6 +132,7 @@ void android_main(struct android_app *app) {
         while (ALooper_pollOnce(0, nullptr, &events, (void **) &source) >= 0) {
             if (source) source->process(app, source);
             if (app->destroyRequested) {
+                g_replay.reset();
                 if (renderer) {
                     delete renderer;
                     renderer = nullptr;
@@ -114,6 +145,8 @@ void android_main(struct android_app *app) {
             if (!renderer && app->window) {
                 LOGI("app here:=>");
                 try {
+                    // before the renderer, it seeds the generators the renderer seeds from
+                    startReplay(app);
                     renderer = new Renderer(app);
                     g_renderer = renderer;
                 } catch (const std::exception &e) {
@@ -122,13 +155,25 @@ void android_main(struct android_app *app) {
                 }
             }
         }
-        Time::updateTime();
         if (g_pendingRestart) {
-            g_renderer->restartGame();
+            ReplayEvent restart{ReplayEventType::Restart};
+            if (g_replay) g_replay->recordInput(restart);
+            Replay::apply(*g_renderer, restart);
             g_pendingRestart = false;
         }
+        if (renderer && g_replay) {
+            if (!g_replay->beginFrame(*renderer, Time::clockDelta())) {
+                // played to the end, hand the game back to the finger
+                LOGI("%s", g_replay->summary().c_str());
+                g_replay.reset();
+                Time::updateTime();
+            }
+        } else {
+            Time::updateTime();
+        }
 
         if (renderer) renderer->drawFrame();
+        if (renderer && g_replay) g_replay->endFrame(*renderer);
     }
 }
 
@@ -0,0 +1,148 @@
+//
+// Created by carlo on 17/10/2026.
+//
+// Times one frame of explosion particle work (update + writing the instance stream) for the old
+// array-of-structs pool against ParticleStore. Both are kept topped up to the same count so
+// every frame also pays for the spawns that replace what died.
+//
+
+#include "ParticleStore.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// what ParticleSystem used to keep per particle, the whole thing got copied into the ring
+struct LegacyParticle {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec3 acceleration;
+    float life;
+    float maxLife;
+    bool active;
+    glm::vec3 center;
+    float size;
+    float rotation;
+    glm::vec4 color;
+};
+
+struct LegacyPool {
+    std::vector<LegacyParticle> particles;
+    std::vector<LegacyParticle> live;
+    uint32_t firstFree = 0;
+    uint32_t activeCount = 0;
+
+    explicit LegacyPool(uint32_t capacity) : particles(capacity) {
+        for (auto &p: particles) p.active = false;
+    }
+
+    void spawn(const glm::vec2 &pos, const glm::vec2 &vel, float life, float size) {
+        LegacyParticle &p = particles[firstFree++ % particles.size()];
+        if (!p.active) activeCount++;
+        p.position = p.center = glm::vec3(pos, 0.0f);
+        p.velocity = glm::vec3(vel, 0.0f);
+        p.acceleration = glm::vec3(0.0f);
+        p.life = p.maxLife = life;
+        p.color = glm::vec4(1, 0.5, 0, 1);
+        p.size = size;
+        p.rotation = 0.0f;
+        p.active = true;
+    }
+
+    // same loop ParticleSystem::updateExplosionParticles ran before the SoA store
+    void update(float dt, void *upload) {
+        live.clear();
+        for (auto &p: particles) {
+            if (!p.active) continue;
+            p.velocity += p.acceleration * dt;
+            p.position += p.velocity * dt;
+            p.center = p.position;
+            p.life -= dt;
+            live.push_back(p);
+            p.color.a = glm::clamp(p.life / p.maxLife, 0.0f, 1.0f);
+            if (p.life <= 0) {
+                p.active = false;
+                activeCount--;
+            }
+        }
+        memcpy(upload, live.data(), live.size() * sizeof(LegacyParticle));
+    }
+};
+
+struct SpawnParams {
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+    void next(glm::vec2 &vel, float &life, float &size) {
+        float angle = unit(rng) * 6.2831853f;
+        vel = glm::vec2(cosf(angle), sinf(angle)) * (0.15f + unit(rng) * 0.15f);
+        life = 0.5f + unit(rng) * 0.3f;
+        size = 0.005f + unit(rng) * 0.005f;
+    }
+};
+
+static constexpr float DT = 1.0f / 60.0f;
+static constexpr int WARMUP_FRAMES = 60;
+static constexpr int FRAMES = 300;
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double benchLegacy(uint32_t count) {
+    LegacyPool pool(count);
+    SpawnParams params;
+    std::vector<uint8_t> upload(count * sizeof(LegacyParticle));
+    double total = 0.0;
+    for (int frame = 0; frame < WARMUP_FRAMES + FRAMES; ++frame) {
+        auto start = Clock::now();
+        while (pool.activeCount < count) {
+            glm::vec2 vel;
+            float life, size;
+            params.next(vel, life, size);
+            pool.spawn(glm::vec2(0.0f), vel, life, size);
+        }
+        pool.update(DT, upload.data());
+        if (frame >= WARMUP_FRAMES) total += msSince(start);
+    }
+    return total / FRAMES;
+}
+
+static double benchStore(uint32_t count, JobSystem *jobs) {
+    ParticleStore store(count);
+    store.setJobSystem(jobs);
+    SpawnParams params;
+    std::vector<ParticleInstance> upload(count);
+    double total = 0.0;
+    for (int frame = 0; frame < WARMUP_FRAMES + FRAMES; ++frame) {
+        auto start = Clock::now();
+        while (store.count() < count) {
+            glm::vec2 vel;
+            float life, size;
+            params.next(vel, life, size);
+            store.spawn(glm::vec2(0.0f), vel, life, size, glm::vec4(1, 0.5, 0, 1));
+        }
+        store.update(DT);
+        store.writeInstances(upload.data());
+        if (frame >= WARMUP_FRAMES) total += msSince(start);
+    }
+    return total / FRAMES;
+}
+
+int main() {
+    printf("bytes uploaded per particle: legacy %zu, store %zu\n",
+           sizeof(LegacyParticle), sizeof(ParticleInstance));
+    printf("%10s %12s %12s %12s\n", "particles", "legacy ms", "soa 1T ms", "soa MT ms");
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    for (uint32_t count: {512u, 10000u, 100000u}) {
+        double legacy = benchLegacy(count);
+        double single = benchStore(count, nullptr);
+        double multi = benchStore(count, &jobs);
+        printf("%10u %12.4f %12.4f %12.4f\n", count, legacy, single, multi);
+    }
+    return 0;
+}
@@ -12,6 +12,7 @@ C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/particles_instanced.frag -o ../..
 
 C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/stars_instanced.vert -o ../../assets/shaders/stars_instanced.vert.spv
 C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/stars_instanced.frag -o ../../assets/shaders/stars_instanced.frag.spv
+C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/stars_procedural.vert -o ../../assets/shaders/stars_procedural.vert.spv
 
 C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/halo.vert -o ../../assets/shaders/halo.vert.spv
 C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/halo.frag -o ../../assets/shaders/halo.frag.spv
@@ -19,3 +20,5 @@ C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/halo.frag -o ../../assets/shaders
 C:/VulkanSDK/1.4.309.0/Bin/glslc.exe aabb/aabb.vert -o ../../assets/shaders/aabb.vert.spv
 C:/VulkanSDK/1.4.309.0/Bin/glslc.exe aabb/aabb.frag -o ../../assets/shaders/aabb.frag.spv
 
+C:/VulkanSDK/1.4.309.0/Bin/glslc.exe particles/particles_simulate.comp -o ../../assets/shaders/particles_simulate.comp.spv
+
@@ -1,6 +1,7 @@
 #version 450
 
-layout (set = 0, binding = 1) uniform sampler2D textures[5];
+// every sprite texture, one layer each (see TextureArray)
+layout (set = 0, binding = 1) uniform sampler2DArray textures;
 
 layout (location = 0) in vec4 fragColor;
 layout (location = 1) in vec2 inUV;
@@ -18,7 +19,7 @@ void main() {
         alpha = 0.8 + 0.2 * sin(inTime * 9.0);
     }
 
-    vec4 texColor = texture(textures[inTexturePos], inUV);
+    vec4 texColor = texture(textures, vec3(inUV, float(inTexturePos)));
     vec3 color = mix(texColor.rgb, vec3(1.0), clamp(inFlashAmount, 0.0f, 1.0f));
     outColor = vec4(color, texColor.a * alpha);
 }
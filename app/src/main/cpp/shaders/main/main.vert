@@ -6,21 +6,21 @@ layout (set = 0, binding = 0) uniform UBO {
     mat4 proj;
 } ubo;
 
-layout (push_constant) uniform AlienPush {
-    vec2 offset;
-    vec2 shakeOffset;
-    float flashAmount;
-    uint texturePos;
-    float deltaTime;
-    uint enablePulse;
-    vec2 size;
-} pc;
-
-
+// Per-vertex (shared sprite quad)
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inColor;
 layout (location = 2) in vec2 inUV;
 
+// Per-instance (SpriteInstance), used to be push constants
+layout (location = 3) in vec2 inOffset;
+layout (location = 4) in vec2 inShakeOffset;
+layout (location = 5) in float inFlashAmount;
+layout (location = 6) in uint inTexturePos;
+layout (location = 7) in float inTime;
+layout (location = 8) in uint inEnablePulse;
+layout (location = 9) in vec2 inSize;
+layout (location = 10) in vec4 inUVRect; // xy offset, zw scale into the texture array layer
+
 layout (location = 0) out vec4 fragColor;
 layout (location = 1) out vec2 outUV;
 layout (location = 2) out float outFlashAmount;
@@ -30,13 +30,12 @@ layout (location = 5) out uint outCanPulse;
 
 void main() {
 
-    gl_Position = vec4((inPos.xy * pc.size) + pc.offset , inPos.z, 1.0);
-    gl_Position.xy += pc.shakeOffset; // shifts everything
-    //    gl_Position = vec4(inPos, 0.0, 1.0);
+    gl_Position = vec4((inPos.xy * inSize) + inOffset , inPos.z, 1.0);
+    gl_Position.xy += inShakeOffset; // shifts everything
     fragColor = vec4(inColor.xy, inColor.z, 1.0);
-    outUV = inUV;
-    outFlashAmount = pc.flashAmount;
-    outTexturePos = pc.texturePos;
-    outTime = pc.deltaTime;
-    outCanPulse = pc.enablePulse;
+    outUV = inUVRect.xy + inUV * inUVRect.zw;
+    outFlashAmount = inFlashAmount;
+    outTexturePos = inTexturePos;
+    outTime = inTime;
+    outCanPulse = inEnablePulse;
 }
@@ -0,0 +1,57 @@
+#version 450
+
+// Stateless star field: every star is a pure function of gl_InstanceIndex, the seed and time,
+// nothing per star lives in a buffer. Instances are split into parallax layers, the back layers
+// are slower, smaller and dimmer. Output matches stars_instanced.vert so the same frag is used.
+
+// Star quad: pos = [-0.5,-0.5] to [0.5,0.5], instanced
+layout(location = 0) in vec3 quadPos;       // per-vertex
+
+layout(push_constant) uniform StarField {
+    float time;          // seconds, wrapped by the CPU every PERIOD
+    uint seed;
+    uint starsPerLayer;
+    uint layerCount;
+} field;
+
+layout(location = 0) out float vStarDist;
+layout(location = 1) out float vBrightness;
+layout(location = 2) out vec3 outQuadPos;
+
+// has to match STAR_FIELD_PERIOD on the CPU side
+const float PERIOD = 440.0;
+const float WRAP = 2.2; // stars travel from -1.1 to 1.1, like the old instanced field
+
+// PCG hash, good enough randomness from a counter
+uint pcg(uint v) {
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float random(uint star, uint channel) {
+    return float(pcg(star * 4u + channel + pcg(field.seed))) / 4294967295.0;
+}
+
+void main() {
+    uint star = uint(gl_InstanceIndex);
+    uint layer = min(star / max(field.starsPerLayer, 1u), field.layerCount - 1u);
+    float depth = float(layer + 1u) / float(field.layerCount); // 1 = front layer
+
+    float speed = mix(0.03, 0.3, depth) * (0.8 + 0.4 * random(star, 0u));
+    float size = mix(0.004, 0.015, depth) * (0.75 + 0.5 * random(star, 1u));
+    float brightness = mix(0.3, 1.0, depth) * (0.7 + 0.3 * random(star, 2u));
+
+    // whole number of trips per PERIOD, so the time wrap on the CPU doesn't make stars jump
+    float trips = max(1.0, floor(speed * PERIOD / WRAP + 0.5));
+    float phase = field.time / PERIOD;
+    float x = random(star, 3u) * WRAP - WRAP * 0.5;
+    float y = fract(random(star, 4u) + trips * phase) * WRAP - WRAP * 0.5;
+
+    vec3 worldPos = vec3(x, y, 0.0) + quadPos * size;
+    gl_Position = vec4(worldPos, 1.0);
+
+    vStarDist = length(quadPos.xy); // 0 at center, ~0.7 at corner
+    vBrightness = brightness;
+    outQuadPos = quadPos;
+}